@@ -452,6 +452,30 @@ FILE* FileSystem::openFile(const char* filePath, const char* mode, bool external
     return fp;
 }
 
+bool FileSystem::renameFile(const char* fromPath, const char* toPath)
+{
+    GP_ASSERT(fromPath);
+    GP_ASSERT(toPath);
+
+    // Resolve both paths the way open() does for a stream opened for writing
+    std::string fromFull, toFull;
+#ifdef __ANDROID__
+    fromFull = __resourcePath;
+    fromFull += resolvePath(fromPath);
+    toFull = __resourcePath;
+    toFull += resolvePath(toPath);
+#else
+    getFullPath(fromPath, fromFull, true);
+    getFullPath(toPath, toFull, true);
+#endif
+
+#ifdef WIN32
+    return MoveFileExA(fromFull.c_str(), toFull.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(fromFull.c_str(), toFull.c_str()) == 0;
+#endif
+}
+
 char* FileSystem::readAll(const char* filePath, int* fileSize, bool external)
 {
     GP_ASSERT(filePath);
@@ -182,6 +182,18 @@ public:
      */
     static FILE* openFile(const char* filePath, const char* mode, bool external = false);
 
+    /**
+     * Renames a file written through open(), replacing any file already at the new path.
+     *
+     * On POSIX systems the replacement is atomic, so a reader sees either the old file or the new one, never part of it.
+     *
+     * @param fromPath The current path of the file, relative to the path files are written under.
+     * @param toPath The new path of the file, relative to the same path.
+     *
+     * @return <code>true</code> if the file was renamed; <code>false</code> otherwise.
+     */
+    static bool renameFile(const char* fromPath, const char* toPath);
+
     /**
      * Reads the entire contents of the specified file and returns its contents.
      *
@@ -59,6 +59,24 @@ public:
      */
     static Mesh* createMesh(const VertexFormat& vertexFormat, unsigned int vertexCount, bool dynamic = false);
 
+    /**
+     * Creates a mesh with no vertex buffer, for carrying collision data where there is no GL context.
+     *
+     * The mesh cannot be drawn - it only stands in for a model's mesh when building mesh collision shapes.
+     *
+     * @param vertexFormat The vertex format.
+     *
+     * @return The created mesh.
+     */
+    static Mesh* createEmpty(const VertexFormat& vertexFormat)
+    {
+        Mesh* mesh = new Mesh(vertexFormat);
+        mesh->_primitiveType = TRIANGLES;
+        mesh->vertices = NULL;
+        mesh->hulls = NULL;
+        return mesh;
+    }
+
     /**
      * Creates a new textured 3D quad.
      *
@@ -17,6 +17,54 @@
 #endif
 #include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
 #include "BulletCollision/CollisionShapes/btShapeHull.h"
+#if BT_THREADSAFE
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
+#endif
+
+namespace gameplay
+{
+
+/**
+ * Dynamics world that counts its active bodies while synchronizing motion states, which Bullet
+ * already does once per update for each non-static body. The count drives the controller's
+ * ACTIVATED/DEACTIVATED status without scanning every collision object in the world.
+ */
+template <class World>
+class ActivityTrackingWorld : public World
+{
+public:
+
+    template <typename... Args>
+    static World* create(int* activeBodies, Args... args)
+    {
+        return new ActivityTrackingWorld(activeBodies, args...);
+    }
+
+    void synchronizeMotionStates()
+    {
+        int activeBodies = 0;
+        for (int i = 0; i < this->m_nonStaticRigidBodies.size(); i++)
+        {
+            if (this->m_nonStaticRigidBodies[i]->isActive())
+                activeBodies++;
+        }
+        *_activeBodies = activeBodies;
+        World::synchronizeMotionStates();
+    }
+
+private:
+
+    template <typename... Args>
+    ActivityTrackingWorld(int* activeBodies, Args... args) : World(args...), _activeBodies(activeBodies) { }
+
+    int* _activeBodies;
+};
+
+}
+
 #ifdef GP_USE_MEM_LEAK_DETECTION
 #define new DEBUG_NEW
 #endif
@@ -24,6 +72,9 @@
 // The initial capacity of the Bullet debug drawer's vertex batch.
 #define INITIAL_CAPACITY 280
 
+// Smallest batch for which endBatch() rebuilds the broadphase.
+#define BATCH_OPTIMIZE_MIN_OBJECTS 64
+
 namespace gameplay
 {
 
@@ -34,19 +85,16 @@ const int PhysicsController::REMOVE        = 0x08;
 
 PhysicsController::PhysicsController()
   : _isUpdating(false), _constraintNoCollide(false),_collisionConfiguration(NULL), _dispatcher(NULL),
-    _overlappingPairCache(NULL), _solver(NULL), _world(NULL), _ghostPairCallback(NULL),
+    _overlappingPairCache(NULL), _solver(NULL), _solverPool(NULL), _taskScheduler(NULL), _world(NULL), _ghostPairCallback(NULL),
     _debugDrawer(NULL), _status(PhysicsController::Listener::DEACTIVATED), _listeners(NULL),
-    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _collisionCallback(NULL)
+    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _fixedTimeStep(1.0f / 60.0f), _maxSubSteps(10),
+    _activeBodies(0), _batchDepth(0), _breakableDirty(true)
 {
     GP_REGISTER_SCRIPT_EVENTS();
-
-    // Default gravity is 9.8 along the negative Y axis.
-    _collisionCallback = new CollisionCallback(this);
 }
 
 PhysicsController::~PhysicsController()
 {
-    SAFE_DELETE(_collisionCallback);
     SAFE_DELETE(_ghostPairCallback);
     SAFE_DELETE(_debugDrawer);
     SAFE_DELETE(_listeners);
@@ -82,6 +130,109 @@ void PhysicsController::removeStatusListener(Listener* listener)
     }
 }
 
+void PhysicsController::beginBatch()
+{
+    _batchDepth++;
+}
+
+void PhysicsController::endBatch()
+{
+    GP_ASSERT(_batchDepth > 0);
+    if (--_batchDepth > 0 || (_batchObjects.empty() && _batchConstraints.empty()))
+        return;
+
+    // Bodies first, so that every constraint finds both of its bodies in the world.
+    for (size_t i = 0; i < _batchObjects.size(); i++)
+        insertCollisionObject(_batchObjects[i]);
+    for (size_t i = 0; i < _batchConstraints.size(); i++)
+        _world->addConstraint(_batchConstraints[i].first->_constraint, _batchConstraints[i].second);
+
+    // The proxies went in one at a time. A top-down rebuild costs as much as the whole world, so it
+    // only pays off when the batch is large and makes up a good part of the world.
+    int batchSize = (int)_batchObjects.size();
+    if (batchSize >= BATCH_OPTIMIZE_MIN_OBJECTS && batchSize * 4 >= _world->getNumCollisionObjects())
+        static_cast<btDbvtBroadphase*>(_overlappingPairCache)->optimize();
+
+    _batchObjects.clear();
+    _batchConstraints.clear();
+}
+
+void PhysicsController::addTickListener(TickListener* listener)
+{
+    GP_ASSERT(listener);
+    if (std::find(_tickListeners.begin(), _tickListeners.end(), listener) == _tickListeners.end())
+        _tickListeners.push_back(listener);
+}
+
+void PhysicsController::removeTickListener(TickListener* listener)
+{
+    GP_ASSERT(listener);
+    std::vector<TickListener*>::iterator iter = std::find(_tickListeners.begin(), _tickListeners.end(), listener);
+    if (iter != _tickListeners.end())
+        _tickListeners.erase(iter);
+}
+
+void PhysicsController::setTimeStep(float fixedTimeStep, int maxSubSteps)
+{
+    GP_ASSERT(fixedTimeStep > 0.0f && maxSubSteps > 0);
+    _fixedTimeStep = fixedTimeStep;
+    _maxSubSteps = maxSubSteps;
+}
+
+void PhysicsController::addConstraintListener(ConstraintListener* listener)
+{
+    GP_ASSERT(listener);
+    if (std::find(_constraintListeners.begin(), _constraintListeners.end(), listener) == _constraintListeners.end())
+        _constraintListeners.push_back(listener);
+    _breakableDirty = true;
+}
+
+void PhysicsController::removeConstraintListener(ConstraintListener* listener)
+{
+    GP_ASSERT(listener);
+    std::vector<ConstraintListener*>::iterator iter = std::find(_constraintListeners.begin(), _constraintListeners.end(), listener);
+    if (iter != _constraintListeners.end())
+        _constraintListeners.erase(iter);
+}
+
+float PhysicsController::getTimeStep() const
+{
+    return _fixedTimeStep;
+}
+
+void PhysicsController::tickCallback(btDynamicsWorld* world, btScalar timeStep)
+{
+    PhysicsController* controller = static_cast<PhysicsController*>(world->getWorldUserInfo());
+    GP_ASSERT(controller);
+
+    // Index rather than iterate, since a listener may remove itself.
+    for (size_t i = 0; i < controller->_tickListeners.size(); i++)
+        controller->_tickListeners[i]->physicsTick(timeStep);
+
+    // Record the breakable constraints' state right before the step, so one that breaks in it starts
+    // out enabled - even if it was disabled and switched back on since the last step, eg. on a relaunch.
+    if (!controller->_constraintListeners.empty())
+    {
+        if (controller->_breakableDirty)
+            controller->updateBreakableConstraints();
+        else
+        {
+            std::vector<std::pair<PhysicsConstraint*, bool> >& breakable = controller->_breakableConstraints;
+            for (size_t i = 0; i < breakable.size(); i++)
+                breakable[i].second = breakable[i].first->_constraint->isEnabled();
+        }
+    }
+}
+
+void PhysicsController::postTickCallback(btDynamicsWorld* world, btScalar timeStep)
+{
+    PhysicsController* controller = static_cast<PhysicsController*>(world->getWorldUserInfo());
+    GP_ASSERT(controller);
+
+    if (!controller->_constraintListeners.empty() && !controller->_breakableDirty)
+        controller->checkBrokenConstraints();
+}
+
 void PhysicsController::setConstraintNoCollide() {
 	_constraintNoCollide = true;
 }
@@ -169,6 +320,11 @@ void PhysicsController::setGravity(const Vector3& gravity)
         _world->setGravity(BV(_gravity));
 }
 
+void PhysicsController::step(float elapsedTime)
+{
+    update(elapsedTime);
+}
+
 void PhysicsController::drawDebug(const Matrix& viewProjection)
 {
     GP_ASSERT(_debugDrawer);
@@ -369,66 +525,43 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
     return false;
 }
 
-btScalar PhysicsController::CollisionCallback::addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, 
-    const btCollisionObjectWrapper* b, int partIdB, int indexB)
+void PhysicsController::contactEvent(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB, const btManifoldPoint& cp)
 {
-    GP_ASSERT(_pc);
-
-    // Get pointers to the PhysicsCollisionObject objects.
-    PhysicsCollisionObject* objectA = _pc->getCollisionObject(a->m_collisionObject);
-    PhysicsCollisionObject* objectB = _pc->getCollisionObject(b->m_collisionObject);
-
     // If the given collision object pair has collided in the past, then
     // we notify the listeners only if the pair was not colliding
     // during the previous frame. Otherwise, it's a new pair, so add a
     // new entry to the cache with the appropriate listeners and notify them.
     PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
 
+    CollisionStatus::iterator found = _collisionStatus.find(pair);
     CollisionInfo* collisionInfo;
-    if (_pc->_collisionStatus.count(pair) > 0)
+    if (found != _collisionStatus.end())
     {
-        collisionInfo = &_pc->_collisionStatus[pair];
+        collisionInfo = &found->second;
     }
     else
     {
         // Add a new collision pair for these objects.
-        collisionInfo = &_pc->_collisionStatus[pair];
+        collisionInfo = &_collisionStatus[pair];
 
         // Add the appropriate listeners.
-        PhysicsCollisionObject::CollisionPair p1(pair.objectA, NULL);
-        if (_pc->_collisionStatus.count(p1) > 0)
-        {
-            const CollisionInfo& ci = _pc->_collisionStatus[p1];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
-        }
-        PhysicsCollisionObject::CollisionPair p2(pair.objectB, NULL);
-        if (_pc->_collisionStatus.count(p2) > 0)
-        {
-            const CollisionInfo& ci = _pc->_collisionStatus[p2];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
-        }
+        CollisionStatus::const_iterator p1 = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(pair.objectA, NULL));
+        if (p1 != _collisionStatus.end())
+            collisionInfo->_listeners.insert(collisionInfo->_listeners.end(), p1->second._listeners.begin(), p1->second._listeners.end());
+        CollisionStatus::const_iterator p2 = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(pair.objectB, NULL));
+        if (p2 != _collisionStatus.end())
+            collisionInfo->_listeners.insert(collisionInfo->_listeners.end(), p2->second._listeners.begin(), p2->second._listeners.end());
     }
 
-    // Fire collision event.
+    // Fire collision event. Listeners may add pairs, which moves hash entries but not the info itself.
     if ((collisionInfo->_status & COLLISION) == 0)
     {
-        std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = collisionInfo->_listeners.begin();
-        for (; iter != collisionInfo->_listeners.end(); iter++)
+        for (size_t i = 0; i < collisionInfo->_listeners.size(); i++)
         {
-            GP_ASSERT(*iter);
+            GP_ASSERT(collisionInfo->_listeners[i]);
             if ((collisionInfo->_status & REMOVE) == 0)
             {
-                (*iter)->collisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, pair, Vector3(cp.getPositionWorldOnA().x(), cp.getPositionWorldOnA().y(), cp.getPositionWorldOnA().z()),
+                collisionInfo->_listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, pair, Vector3(cp.getPositionWorldOnA().x(), cp.getPositionWorldOnA().y(), cp.getPositionWorldOnA().z()),
                     Vector3(cp.getPositionWorldOnB().x(), cp.getPositionWorldOnB().y(), cp.getPositionWorldOnB().z()));
             }
         }
@@ -439,18 +572,60 @@ btScalar PhysicsController::CollisionCallback::addSingleResult(btManifoldPoint&
     // status is not reset to 'no collision' when the controller's update completes).
     collisionInfo->_status &= ~DIRTY;
     collisionInfo->_status |= COLLISION;
-    return 0.0f;
+}
+
+bool PhysicsController::isListening(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB) const
+{
+    CollisionStatus::const_iterator iter = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(objectA, objectB));
+    return iter != _collisionStatus.end() && (iter->second._status & (REGISTERED | REMOVE)) == REGISTERED;
 }
 
 void PhysicsController::initialize()
 {
     _collisionConfiguration = bullet_new<btDefaultCollisionConfiguration>();
-    _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
     _overlappingPairCache = bullet_new<btDbvtBroadphase>();
-    _solver = bullet_new<btSequentialImpulseConstraintSolver>();
 
-    // Create the world.
-    _world = bullet_new<btDiscreteDynamicsWorld>(_dispatcher, _overlappingPairCache, _solver, _collisionConfiguration);
+#if BT_THREADSAFE
+    // The multithreaded world is opt-in through the "physics" section of the game config:
+    //
+    //   physics
+    //   {
+    //       multithreaded = true
+    //       threads = 4   // defaults to all available cores
+    //   }
+    Properties* config = Game::getInstance()->getConfig()->getNamespace("physics", true);
+    if (config && config->getBool("multithreaded"))
+    {
+        _taskScheduler = btCreateDefaultTaskScheduler();
+        if (_taskScheduler)
+        {
+            int threads = config->exists("threads") ? config->getInt("threads") : _taskScheduler->getMaxNumThreads();
+            _taskScheduler->setNumThreads(threads);
+            btSetTaskScheduler(_taskScheduler);
+
+            // Narrowphase pairs and simulation islands are processed in parallel,
+            // with a pool of solvers so that independent islands solve concurrently.
+            _dispatcher = bullet_new<btCollisionDispatcherMt>(_collisionConfiguration, 40);
+            _solver = bullet_new<btSequentialImpulseConstraintSolverMt>();
+            _solverPool = bullet_new<btConstraintSolverPoolMt>(_taskScheduler->getNumThreads());
+            _world = ActivityTrackingWorld<btDiscreteDynamicsWorldMt>::create(&_activeBodies, _dispatcher, _overlappingPairCache, _solverPool, _solver, _collisionConfiguration);
+            print("Using multithreaded physics with %d threads.\n", _taskScheduler->getNumThreads());
+        }
+        else
+        {
+            GP_WARN("No Bullet task scheduler available; using single-threaded physics.");
+        }
+    }
+#endif
+
+    if (!_world)
+    {
+        _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
+        _solver = bullet_new<btSequentialImpulseConstraintSolver>();
+
+        // Create the world.
+        _world = ActivityTrackingWorld<btDiscreteDynamicsWorld>::create(&_activeBodies, _dispatcher, _overlappingPairCache, _solver, _collisionConfiguration);
+    }
     _world->setGravity(BV(_gravity));
 
     // Register ghost pair callback so bullet detects collisions with ghost objects (used for character collisions).
@@ -459,6 +634,12 @@ void PhysicsController::initialize()
     _world->getPairCache()->setInternalGhostPairCallback(_ghostPairCallback);
     _world->getDispatchInfo().m_allowedCcdPenetration = 0.0001f;
 
+    // Let fixed step listeners run before every internal step.
+    _world->setInternalTickCallback(tickCallback, this, true);
+
+    // Check for broken constraints after every internal step, while the solver's impulses are still set.
+    _world->setInternalTickCallback(postTickCallback, this, false);
+
     // Set up debug drawing.
     _debugDrawer = new DebugDrawer();
     _world->setDebugDrawer(_debugDrawer);
@@ -469,10 +650,18 @@ void PhysicsController::finalize()
     // Clean up the world and its various components.
     SAFE_DELETE(_world);
     SAFE_DELETE(_ghostPairCallback);
+    SAFE_DELETE(_solverPool);
     SAFE_DELETE(_solver);
     SAFE_DELETE(_overlappingPairCache);
     SAFE_DELETE(_dispatcher);
     SAFE_DELETE(_collisionConfiguration);
+#if BT_THREADSAFE
+    if (_taskScheduler)
+    {
+        btSetTaskScheduler(NULL);
+        SAFE_DELETE(_taskScheduler);
+    }
+#endif
 }
 
 void PhysicsController::pause()
@@ -490,46 +679,24 @@ void PhysicsController::update(float elapsedTime)
     GP_ASSERT(_world);
     _isUpdating = true;
 
-    // Update the physics simulation, with a maximum
-    // of 10 simulation steps being performed in a given frame.
+    // Index rather than iterate, since a listener may remove itself.
+    for (size_t i = 0; i < _tickListeners.size(); i++)
+        _tickListeners[i]->physicsUpdate();
+
+    // Update the physics simulation in fixed steps, with at most _maxSubSteps
+    // steps being performed in a given frame. Bullet interpolates the motion
+    // states between steps for the remainder.
     //
     // Note that stepSimulation takes elapsed time in seconds
     // so we divide by 1000 to convert from milliseconds.
-    _world->stepSimulation(elapsedTime * 0.001f, 10);
+    _world->stepSimulation(elapsedTime * 0.001f, _maxSubSteps, _fixedTimeStep);
 
-    // If we have status listeners, then check if our status has changed.
+    // If we have status listeners, then check if our status has changed. The world counts
+    // its active bodies while synchronizing motion states, so this costs nothing extra.
     if (_listeners || hasScriptListener(GP_GET_SCRIPT_EVENT(PhysicsController, statusEvent)))
     {
         Listener::EventType oldStatus = _status;
-
-        if (_status == Listener::DEACTIVATED)
-        {
-            for (int i = 0; i < _world->getNumCollisionObjects(); i++)
-            {
-                GP_ASSERT(_world->getCollisionObjectArray()[i]);
-                if (_world->getCollisionObjectArray()[i]->isActive())
-                {
-                    _status = Listener::ACTIVATED;
-                    break;
-                }
-            }
-        }
-        else
-        {
-            bool allInactive = true;
-            for (int i = 0; i < _world->getNumCollisionObjects(); i++)
-            {
-                GP_ASSERT(_world->getCollisionObjectArray()[i]);
-                if (_world->getCollisionObjectArray()[i]->isActive())
-                {
-                    allInactive = false;
-                    break;
-                }
-            }
-
-            if (allInactive)
-                _status = Listener::DEACTIVATED;
-        }
+        _status = _activeBodies > 0 ? Listener::ACTIVATED : Listener::DEACTIVATED;
 
         // If the status has changed, notify our listeners.
         if (oldStatus != _status)
@@ -547,32 +714,65 @@ void PhysicsController::update(float elapsedTime)
         }
     }
 
+    if (!_collisionStatus.empty())
+        updateCollisionStatus();
+
+    _isUpdating = false;
+}
+
+void PhysicsController::updateBreakableConstraints()
+{
+    // Only constraints with a finite breaking threshold can be broken by the solver.
+    _breakableConstraints.clear();
+    for (std::unordered_set<PhysicsConstraint*>::iterator iter = _constraints.begin(); iter != _constraints.end(); iter++)
+    {
+        btTypedConstraint* constraint = (*iter)->_constraint;
+        if (constraint->getBreakingImpulseThreshold() < SIMD_INFINITY)
+            _breakableConstraints.push_back(std::make_pair(*iter, constraint->isEnabled()));
+    }
+    _breakableDirty = false;
+}
+
+void PhysicsController::checkBrokenConstraints()
+{
+    // Bullet's solver disables a constraint when the impulse it applies reaches the breaking
+    // threshold. The applied impulse is reset at the start of every step, so this must run
+    // right after the step that broke it; a deliberately disabled constraint reads 0 here.
+    std::vector<PhysicsConstraint*> broken;
+    for (size_t i = 0; i < _breakableConstraints.size(); i++)
+    {
+        btTypedConstraint* constraint = _breakableConstraints[i].first->_constraint;
+        bool enabled = constraint->isEnabled();
+        if (_breakableConstraints[i].second && !enabled && btFabs(constraint->internalGetAppliedImpulse()) >= constraint->getBreakingImpulseThreshold())
+            broken.push_back(_breakableConstraints[i].first);
+    }
+
+    for (size_t i = 0; i < broken.size(); i++)
+    {
+        for (size_t j = 0; j < _constraintListeners.size(); j++)
+            _constraintListeners[j]->constraintBroken(broken[i]);
+    }
+}
+
+void PhysicsController::updateCollisionStatus()
+{
     // All statuses are set with the DIRTY bit before collision processing occurs.
     // During collision processing, if a collision occurs, the status is 
     // set to COLLISION and the DIRTY bit is cleared. Then, after collision processing 
     // is finished, if a given status is still dirty, the COLLISION bit is cleared.
     //
     // If an entry was marked for removal in the last frame, fire NOT_COLLIDING if appropriate and remove it now.
+    // Events are fired after the pass, since a listener adding a pair could rehash the table.
+    std::vector<std::pair<PhysicsCollisionObject::CollisionPair, CollisionInfo> > ended;
 
     // Dirty the collision status cache entries.
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end();)
+    for (CollisionStatus::iterator iter = _collisionStatus.begin(); iter != _collisionStatus.end();)
     {
         if ((iter->second._status & REMOVE) != 0)
         {
             if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
-            {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
-                {
-                    PhysicsCollisionObject::CollisionPair cp(iter->first.objectA, NULL);
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, cp);
-                }
-            }
-
-            std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator eraseIter = iter;
-            iter++;
-            _collisionStatus.erase(eraseIter);
+                ended.push_back(std::make_pair(PhysicsCollisionObject::CollisionPair(iter->first.objectA, NULL), iter->second));
+            iter = _collisionStatus.erase(iter);
         }
         else
         {
@@ -581,42 +781,49 @@ void PhysicsController::update(float elapsedTime)
         }
     }
 
-    // Go through the collision status cache and perform all registered collision tests.
-    iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end(); iter++)
+    // Bullet's narrowphase has already found every contact this step, so rather than querying
+    // each registered pair, read the contact manifolds and keep the ones that are being listened for.
+    // Manifolds keep points out to the contact breaking threshold, so only points at or below zero
+    // distance count as touching, as with contactPairTest.
+    btDispatcher* dispatcher = _world->getDispatcher();
+    for (int i = 0; i < dispatcher->getNumManifolds(); i++)
     {
-        // If this collision pair was one that was registered for listening, then perform the collision test.
-        // (In the case where we register for all collisions with a rigid body, there will be a lot
-        // of collision pairs in the status cache that we did not explicitly register for.)
-        if ((iter->second._status & REGISTERED) != 0 && (iter->second._status & REMOVE) == 0)
+        btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+        int contact = -1;
+        for (int j = 0; j < manifold->getNumContacts() && contact < 0; j++)
         {
-            if (iter->first.objectB)
-                _world->contactPairTest(iter->first.objectA->getCollisionObject(), iter->first.objectB->getCollisionObject(), *_collisionCallback);
-            else
-                _world->contactTest(iter->first.objectA->getCollisionObject(), *_collisionCallback);
+            if (manifold->getContactPoint(j).getDistance() <= 0.0f)
+                contact = j;
         }
+        if (contact < 0)
+            continue;
+        PhysicsCollisionObject* objectA = getCollisionObject(manifold->getBody0());
+        PhysicsCollisionObject* objectB = getCollisionObject(manifold->getBody1());
+        if (!objectA || !objectB)
+            continue;
+        if (isListening(objectA, objectB) || isListening(objectA, NULL) || isListening(objectB, NULL))
+            contactEvent(objectA, objectB, manifold->getContactPoint(contact));
     }
 
     // Update all the collision status cache entries.
-    iter = _collisionStatus.begin();
-    for ( ; iter != _collisionStatus.end(); iter++)
+    for (CollisionStatus::iterator iter = _collisionStatus.begin(); iter != _collisionStatus.end(); iter++)
     {
         if ((iter->second._status & DIRTY) != 0)
         {
             if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
-            {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
-                {
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, iter->first);
-                }
-            }
-
+                ended.push_back(*iter);
             iter->second._status &= ~COLLISION;
         }
     }
 
-    _isUpdating = false;
+    for (size_t i = 0; i < ended.size(); i++)
+    {
+        const std::vector<PhysicsCollisionObject::CollisionListener*>& listeners = ended[i].second._listeners;
+        for (size_t j = 0; j < listeners.size(); j++)
+        {
+            listeners[j]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, ended[i].first);
+        }
+    }
 }
 
 void PhysicsController::addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
@@ -640,9 +847,10 @@ void PhysicsController::removeCollisionListener(PhysicsCollisionObject::Collisio
     PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
 
     // Mark the collision pair for these objects for removal.
-    if (_collisionStatus.count(pair) > 0)
+    CollisionStatus::iterator iter = _collisionStatus.find(pair);
+    if (iter != _collisionStatus.end())
     {
-        _collisionStatus[pair]._status |= REMOVE;
+        iter->second._status |= REMOVE;
     }
 }
 
@@ -654,6 +862,18 @@ void PhysicsController::addCollisionObject(PhysicsCollisionObject* object)
     // Assign user pointer for the bullet collision object to allow efficient
     // lookups of bullet objects -> gameplay objects.
     object->getCollisionObject()->setUserPointer(object);
+
+    // Inside a batch, the object waits to be inserted with the rest in endBatch().
+    if (_batchDepth > 0)
+    {
+        _batchObjects.push_back(object);
+        return;
+    }
+    insertCollisionObject(object);
+}
+
+void PhysicsController::insertCollisionObject(PhysicsCollisionObject* object)
+{
     short group = (short)object->_group;
     short mask = (short)object->_mask;
 
@@ -684,8 +904,14 @@ void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bo
     GP_ASSERT(_world);
     GP_ASSERT(!_isUpdating);
 
+    // An object still waiting in a batch was never added to the world.
+    std::vector<PhysicsCollisionObject*>::iterator pending = std::find(_batchObjects.begin(), _batchObjects.end(), object);
+    if (pending != _batchObjects.end())
+    {
+        _batchObjects.erase(pending);
+    }
     // Remove the collision object from the world.
-    if (object->getCollisionObject())
+    else if (object->getCollisionObject())
     {
         switch (object->getType())
         {
@@ -707,8 +933,7 @@ void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bo
     // Find all references to the object in the collision status cache and mark them for removal.
     if (removeListeners)
     {
-        std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-        for (; iter != _collisionStatus.end(); iter++)
+        for (CollisionStatus::iterator iter = _collisionStatus.begin(); iter != _collisionStatus.end(); iter++)
         {
             if (iter->first.objectA == object || iter->first.objectB == object)
                 iter->second._status |= REMOVE;
@@ -1126,6 +1351,22 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         }
     }
 
+    // Reuse the compound shape for these hulls if another body already built it.
+    size_t hullHash = 0;
+    if (!dynamic && mesh->hulls)
+    {
+        hullHash = hashHulls(*mesh->hulls, scale);
+        std::pair<std::multimap<size_t, HullShape>::iterator, std::multimap<size_t, HullShape>::iterator> range = _hullShapes.equal_range(hullHash);
+        for (std::multimap<size_t, HullShape>::iterator it = range.first; it != range.second; ++it)
+        {
+            if (it->second.scale == scale && it->second.hulls == *mesh->hulls)
+            {
+                it->second.shape->addRef();
+                return it->second.shape;
+            }
+        }
+    }
+
     // Read mesh data from URL
     Bundle::MeshData* data = NULL;
     if(hasURL) {
@@ -1199,6 +1440,14 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
     shape->_shapeData.meshData = shapeMeshData;
 
     _shapes.push_back(shape);
+    if (!dynamic && mesh->hulls)
+    {
+        HullShape entry;
+        entry.scale = scale;
+        entry.hulls = *mesh->hulls;
+        entry.shape = shape;
+        _hullShapes.insert(std::make_pair(hullHash, entry));
+    }
 
     // Free the temporary mesh data now that it's stored in physics system.
     if(data) SAFE_DELETE(data);
@@ -1216,6 +1465,17 @@ void PhysicsController::destroyShape(PhysicsCollisionShape* shape)
             std::vector<PhysicsCollisionShape*>::iterator shapeItr = std::find(_shapes.begin(), _shapes.end(), shape);
             if (shapeItr != _shapes.end())
                 _shapes.erase(shapeItr);
+            if (shape->getType() == PhysicsCollisionShape::SHAPE_MESH)
+            {
+                for (std::multimap<size_t, HullShape>::iterator it = _hullShapes.begin(); it != _hullShapes.end(); ++it)
+                {
+                    if (it->second.shape == shape)
+                    {
+                        _hullShapes.erase(it);
+                        break;
+                    }
+                }
+            }
         }
 
         // Release the shape.
@@ -1223,6 +1483,26 @@ void PhysicsController::destroyShape(PhysicsCollisionShape* shape)
     }
 }
 
+size_t PhysicsController::hashHulls(const std::vector<std::vector<Vector3> >& hulls, const Vector3& scale)
+{
+    // FNV-1a over the raw vertex coordinates, hull sizes and scale
+    size_t hash = 2166136261u;
+    const float* f = &scale.x;
+    for (unsigned int k = 0; k < 3; ++k)
+        hash = (hash ^ *(const unsigned int*)&f[k]) * 16777619u;
+    for (unsigned int i = 0; i < hulls.size(); ++i)
+    {
+        hash = (hash ^ hulls[i].size()) * 16777619u;
+        for (unsigned int j = 0; j < hulls[i].size(); ++j)
+        {
+            f = &hulls[i][j].x;
+            for (unsigned int k = 0; k < 3; ++k)
+                hash = (hash ^ *(const unsigned int*)&f[k]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
 void PhysicsController::addConstraint(PhysicsRigidBody* a, PhysicsRigidBody* b, PhysicsConstraint* constraint)
 {
     GP_ASSERT(a);
@@ -1235,8 +1515,13 @@ void PhysicsController::addConstraint(PhysicsRigidBody* a, PhysicsRigidBody* b,
         b->addConstraint(constraint);
     }
     
-    _world->addConstraint(constraint->_constraint, _constraintNoCollide);
+    if (_batchDepth > 0)
+        _batchConstraints.push_back(std::make_pair(constraint, _constraintNoCollide));
+    else
+        _world->addConstraint(constraint->_constraint, _constraintNoCollide);
     _constraintNoCollide = false;
+    _constraints.insert(constraint);
+    _breakableDirty = true;
 }
 
 bool PhysicsController::checkConstraintRigidBodies(PhysicsRigidBody* a, PhysicsRigidBody* b)
@@ -1265,6 +1550,18 @@ void PhysicsController::removeConstraint(PhysicsConstraint* constraint)
     GP_ASSERT(constraint);
     GP_ASSERT(_world);
 
+    _constraints.erase(constraint);
+    _breakableDirty = true;
+
+    for (size_t i = 0; i < _batchConstraints.size(); i++)
+    {
+        if (_batchConstraints[i].first == constraint)
+        {
+            _batchConstraints.erase(_batchConstraints.begin() + i);
+            return;
+        }
+    }
+
     // Find the constraint and remove it from the physics world.
     for (int i = _world->getNumConstraints() - 1; i >= 0; i--)
     {
@@ -1411,6 +1708,22 @@ PhysicsController::Listener::~Listener()
     Game::getInstance()->getPhysicsController()->removeStatusListener(this);
 }
 
+void PhysicsController::TickListener::physicsUpdate()
+{
+}
+
+PhysicsController::TickListener::~TickListener()
+{
+    GP_ASSERT(Game::getInstance()->getPhysicsController());
+    Game::getInstance()->getPhysicsController()->removeTickListener(this);
+}
+
+PhysicsController::ConstraintListener::~ConstraintListener()
+{
+    GP_ASSERT(Game::getInstance()->getPhysicsController());
+    Game::getInstance()->getPhysicsController()->removeConstraintListener(this);
+}
+
 PhysicsController::HitFilter::HitFilter()
 {
 }
@@ -12,6 +12,11 @@
 #include "HeightField.h"
 #include "ScriptTarget.h"
 #include "Node.h"
+#include <unordered_map>
+#include <unordered_set>
+
+class btConstraintSolverPoolMt;
+class btITaskScheduler;
 
 namespace gameplay
 {
@@ -75,6 +80,59 @@ public:
         virtual ~Listener();
     };
 
+    /**
+     * Fixed timestep listener interface, for logic that must advance with the simulation
+     * rather than with the frame rate.
+     */
+    class TickListener
+    {
+    public:
+
+        /**
+         * Called before each fixed simulation step.
+         *
+         * @param timeStep The length of the step, in seconds.
+         */
+        virtual void physicsTick(float timeStep) = 0;
+
+        /**
+         * Called at the start of each update, before the world is stepped and before Bullet
+         * writes body transforms back to their nodes - even in an update that takes no fixed step.
+         */
+        virtual void physicsUpdate();
+
+    protected:
+
+        /**
+         * Destructor.
+         */
+        virtual ~TickListener();
+    };
+
+    /**
+     * Constraint listener interface, notified when the solver breaks a constraint.
+     */
+    class ConstraintListener
+    {
+    public:
+
+        /**
+         * Called after the internal physics step in which the given constraint's breaking impulse was exceeded.
+         *
+         * Breaking thresholds are read when a constraint or listener is added; set the threshold before then.
+         *
+         * @param constraint The constraint that broke, which is now disabled.
+         */
+        virtual void constraintBroken(PhysicsConstraint* constraint) = 0;
+
+    protected:
+
+        /**
+         * Destructor.
+         */
+        virtual ~ConstraintListener();
+    };
+
     /**
      * Structure that stores hit test results for ray and sweep tests.
      */
@@ -171,6 +229,64 @@ public:
      */
     void removeStatusListener(Listener* listener);
 
+    /**
+     * Starts a batch of collision objects and constraints. Until the matching endBatch() call, new
+     * objects and constraints are built as usual but are kept out of the world. Batches may nest.
+     */
+    void beginBatch();
+
+    /**
+     * Ends a batch; when the outermost batch ends, everything created during it is added to the
+     * world in one pass, bodies before constraints. The broadphase is rebuilt once afterwards if the
+     * batch is large and makes up at least a quarter of the world; small batches are simply inserted.
+     */
+    void endBatch();
+
+    /**
+     * Adds a listener to be called before each fixed simulation step.
+     * 
+     * @param listener The listener to add.
+     */
+    void addTickListener(TickListener* listener);
+
+    /**
+     * Removes a fixed step listener.
+     * 
+     * @param listener The listener to remove.
+     */
+    void removeTickListener(TickListener* listener);
+
+    /**
+     * Adds a listener to be notified of broken constraints.
+     * 
+     * @param listener The listener to add.
+     */
+    void addConstraintListener(ConstraintListener* listener);
+
+    /**
+     * Removes a constraint listener.
+     * 
+     * @param listener The listener to remove.
+     */
+    void removeConstraintListener(ConstraintListener* listener);
+
+    /**
+     * Sets the fixed simulation step and the most steps taken per update. Node transforms are
+     * interpolated between steps, and time beyond maxSubSteps steps in one update is dropped,
+     * so results do not depend on the frame rate and a slow frame costs at most maxSubSteps steps.
+     * 
+     * @param fixedTimeStep The length of one step, in seconds.
+     * @param maxSubSteps The maximum number of steps per update.
+     */
+    void setTimeStep(float fixedTimeStep, int maxSubSteps);
+
+    /**
+     * Gets the length of one fixed simulation step.
+     * 
+     * @return The step length, in seconds.
+     */
+    float getTimeStep() const;
+
     //call before adding a constraint to indicate the constrained objects should not collide
     void setConstraintNoCollide();
 
@@ -305,6 +421,13 @@ public:
      */
     void setGravity(const Vector3& gravity);
 
+    /**
+     * Advances the simulation outside of the game loop, eg. when running without a window.
+     * 
+     * @param elapsedTime The time to simulate, in milliseconds.
+     */
+    void step(float elapsedTime);
+
     /**
      * Draws debugging information (rigid body outlines, etc.) using the given view projection matrix.
      * 
@@ -347,29 +470,6 @@ public:
 
 private:
 
-    /**
-     * Internal class used to integrate with Bullet collision callbacks.
-     */
-    class CollisionCallback : public btCollisionWorld::ContactResultCallback
-    {
-    public:
-        /**
-         * Constructor.
-         * 
-         * @param pc The physics controller that owns the callback.
-         */
-        CollisionCallback(PhysicsController* pc) : _pc(pc) {}
-
-    protected:
-        /**
-            * Internal function used for Bullet integration (do not use or override).
-            */
-        btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, const btCollisionObjectWrapper* b, int partIdB, int indexB);    
-
-    private:
-        PhysicsController* _pc;
-    };
-
     // Internal constants for the collision status cache.
     static const int DIRTY;
     static const int COLLISION;
@@ -385,6 +485,26 @@ private:
         int _status;
     };
 
+    // Hashes a collision pair the same way regardless of the order of its objects, matching CollisionPair's ordering.
+    struct CollisionPairHash
+    {
+        size_t operator()(const PhysicsCollisionObject::CollisionPair& pair) const
+        {
+            size_t a = (size_t)pair.objectA, b = (size_t)pair.objectB;
+            return a < b ? a * 31 + b : b * 31 + a;
+        }
+    };
+
+    struct CollisionPairEqual
+    {
+        bool operator()(const PhysicsCollisionObject::CollisionPair& p1, const PhysicsCollisionObject::CollisionPair& p2) const
+        {
+            return (p1.objectA == p2.objectA && p1.objectB == p2.objectB) || (p1.objectA == p2.objectB && p1.objectB == p2.objectA);
+        }
+    };
+
+    typedef std::unordered_map<PhysicsCollisionObject::CollisionPair, CollisionInfo, CollisionPairHash, CollisionPairEqual> CollisionStatus;
+
     /**
      * Constructor.
      */
@@ -420,6 +540,30 @@ private:
      */
     void update(float elapsedTime);
 
+    // Adds a collision object to the world, bypassing any batch.
+    void insertCollisionObject(PhysicsCollisionObject* object);
+
+    // Checks the collision status cache against this update's contact manifolds and fires collision events.
+    void updateCollisionStatus();
+
+    // Whether a listener is registered (and not being removed) for the given pair.
+    bool isListening(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB) const;
+
+    // Records a contact between the two objects, firing COLLIDING if they were not already in contact.
+    void contactEvent(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB, const btManifoldPoint& cp);
+
+    // Collects the constraints with a finite breaking threshold and their current enabled state.
+    void updateBreakableConstraints();
+
+    // Fires constraintBroken for breakable constraints the solver disabled during the last internal step.
+    void checkBrokenConstraints();
+
+    // Bullet's pre-tick callback; passes each fixed step on to the tick listeners.
+    static void tickCallback(btDynamicsWorld* world, btScalar timeStep);
+
+    // Bullet's post-tick callback; checks for constraints broken in the step just taken.
+    static void postTickCallback(btDynamicsWorld* world, btScalar timeStep);
+
     // Adds the given collision listener for the two given collision objects.
     void addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
 
@@ -457,6 +601,9 @@ private:
     // Destroys a collision shape created through PhysicsController
     void destroyShape(PhysicsCollisionShape* shape);
 
+    // Hashes a set of convex hulls at a given scale, for looking up cached hull shapes.
+    static size_t hashHulls(const std::vector<std::vector<Vector3> >& hulls, const Vector3& scale);
+
     // Legacy method for grayscale heightmaps: r + g + b, normalized.
     static float normalizedHeightGrayscale(float r, float g, float b);
 
@@ -553,15 +700,36 @@ private:
     btCollisionDispatcher* _dispatcher;
     btBroadphaseInterface* _overlappingPairCache;
     btSequentialImpulseConstraintSolver* _solver;
+    btConstraintSolverPoolMt* _solverPool;
+    btITaskScheduler* _taskScheduler;
     btDynamicsWorld* _world;
     btGhostPairCallback* _ghostPairCallback;
     std::vector<PhysicsCollisionShape*> _shapes;
+
+    // Compound hull shape shared by every body with the same hulls and scale (eg. clones of a catalog item).
+    struct HullShape
+    {
+        Vector3 scale;
+        std::vector<std::vector<Vector3> > hulls;
+        PhysicsCollisionShape* shape;
+    };
+    std::multimap<size_t, HullShape> _hullShapes;
     DebugDrawer* _debugDrawer;
     Listener::EventType _status;
     std::vector<Listener*>* _listeners;
     Vector3 _gravity;
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo> _collisionStatus;
-    CollisionCallback* _collisionCallback;
+    float _fixedTimeStep;
+    int _maxSubSteps;
+    std::vector<TickListener*> _tickListeners;
+    std::vector<ConstraintListener*> _constraintListeners;
+    std::unordered_set<PhysicsConstraint*> _constraints;
+    std::vector<std::pair<PhysicsConstraint*, bool> > _breakableConstraints; // with each one's enabled state just before the current step
+    bool _breakableDirty;
+    CollisionStatus _collisionStatus;
+    int _activeBodies;
+    int _batchDepth;
+    std::vector<PhysicsCollisionObject*> _batchObjects;
+    std::vector<std::pair<PhysicsConstraint*, bool> > _batchConstraints; // constraint and whether its bodies ignore each other
 };
 
 }
@@ -287,6 +287,153 @@ int PhysicsRigidBody::getActivation()
 	return _body->getActivationState();
 }
 
+void PhysicsRigidBody::updateShape(const PhysicsCollisionShape::Definition& shape)
+{
+    GP_ASSERT(_body);
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    GP_ASSERT(controller);
+
+    Vector3 centerOfMassOffset;
+    PhysicsCollisionShape* collisionShape = controller->createShape(_node, shape, &centerOfMassOffset, false);
+    if (!collisionShape || !collisionShape->getShape())
+    {
+        GP_ERROR("Failed to update collision shape for node '%s'.", _node->getId());
+        return;
+    }
+
+    // Contact algorithms cached for the old shape must go before it does.
+    btBroadphaseProxy* proxy = _body->getBroadphaseHandle();
+    if (proxy)
+        controller->_world->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(proxy, controller->_world->getDispatcher());
+
+    PhysicsCollisionShape* oldShape = _collisionShape;
+    _collisionShape = collisionShape;
+    _body->setCollisionShape(_collisionShape->getShape());
+    controller->destroyShape(oldShape);
+
+    btVector3 localInertia(0.0, 0.0, 0.0);
+    if (_mass != 0.0f)
+        _collisionShape->getShape()->calculateLocalInertia(_mass, localInertia);
+    _body->setMassProps(_mass, localInertia);
+
+    // The center of mass offset scales with the shape. Constraint frames are given relative
+    // to the center of mass, so they move the other way to stay on the same points of the node.
+    Vector3 oldOffset(_motionState->_centerOfMassOffset.getOrigin().x(), _motionState->_centerOfMassOffset.getOrigin().y(),
+        _motionState->_centerOfMassOffset.getOrigin().z());
+    _motionState->setCenterOfMassOffset(centerOfMassOffset);
+    if (_constraints)
+    {
+        Vector3 shift = centerOfMassOffset - oldOffset;
+        for (unsigned int i = 0; i < _constraints->size(); ++i)
+            shiftConstraintFrame((*_constraints)[i], shift);
+    }
+    syncTransform();
+}
+
+void PhysicsRigidBody::shiftConstraintFrame(PhysicsConstraint* constraint, const Vector3& shift)
+{
+    GP_ASSERT(constraint);
+    btTypedConstraint* c = constraint->_constraint;
+    if (!c || shift.lengthSquared() <= MATH_EPSILON)
+        return;
+    bool isA = &c->getRigidBodyA() == _body, isB = &c->getRigidBodyB() == _body;
+    btVector3 offset = BV(shift);
+
+    switch (c->getConstraintType())
+    {
+    case D6_CONSTRAINT_TYPE:
+    case D6_SPRING_CONSTRAINT_TYPE:
+    {
+        btGeneric6DofConstraint* d6 = static_cast<btGeneric6DofConstraint*>(c);
+        btTransform frameA = d6->getFrameOffsetA(), frameB = d6->getFrameOffsetB();
+        if (isA)
+            frameA.getOrigin() += offset;
+        if (isB)
+            frameB.getOrigin() += offset;
+        d6->setFrames(frameA, frameB);
+        break;
+    }
+    case HINGE_CONSTRAINT_TYPE:
+    {
+        btHingeConstraint* hinge = static_cast<btHingeConstraint*>(c);
+        btTransform frameA = hinge->getAFrame(), frameB = hinge->getBFrame();
+        if (isA)
+            frameA.getOrigin() += offset;
+        if (isB)
+            frameB.getOrigin() += offset;
+        hinge->setFrames(frameA, frameB);
+        break;
+    }
+    case CONETWIST_CONSTRAINT_TYPE:
+    {
+        btConeTwistConstraint* cone = static_cast<btConeTwistConstraint*>(c);
+        btTransform frameA = cone->getAFrame(), frameB = cone->getBFrame();
+        if (isA)
+            frameA.getOrigin() += offset;
+        if (isB)
+            frameB.getOrigin() += offset;
+        cone->setFrames(frameA, frameB);
+        break;
+    }
+    case POINT2POINT_CONSTRAINT_TYPE:
+    {
+        btPoint2PointConstraint* p2p = static_cast<btPoint2PointConstraint*>(c);
+        if (isA)
+            p2p->setPivotA(p2p->getPivotInA() + offset);
+        if (isB)
+            p2p->setPivotB(p2p->getPivotInB() + offset);
+        break;
+    }
+    default:
+        GP_WARN("Constraint type %d on node '%s' keeps its frame after a center of mass change.", c->getConstraintType(), _node->getId());
+        break;
+    }
+}
+
+void PhysicsRigidBody::syncTransform()
+{
+    GP_ASSERT(_body);
+    GP_ASSERT(_motionState);
+
+    _motionState->updateTransformFromNode();
+    btTransform transform;
+    _motionState->getWorldTransform(transform);
+    _body->setCenterOfMassTransform(transform);
+
+    // Moving the proxy within the broadphase tree leaves its structure alone.
+    if (_body->getBroadphaseHandle())
+        Game::getInstance()->getPhysicsController()->_world->updateSingleAabb(_body);
+}
+
+void PhysicsRigidBody::setMass(float mass)
+{
+    GP_ASSERT(_body);
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    GP_ASSERT(controller);
+
+    // Bullet only sorts bodies into static and dynamic when they are added to the world,
+    // so a body in the world or waiting in a batch goes back through the controller.
+    bool added = _body->getBroadphaseHandle() != NULL
+        || std::find(controller->_batchObjects.begin(), controller->_batchObjects.end(), this) != controller->_batchObjects.end();
+    if (added)
+        controller->removeCollisionObject(this, false);
+
+    _mass = mass;
+    btVector3 localInertia(0.0, 0.0, 0.0);
+    if (_mass != 0.0f)
+        _collisionShape->getShape()->calculateLocalInertia(_mass, localInertia);
+    _body->setMassProps(_mass, localInertia);
+    _body->updateInertiaTensor();
+    if (_mass == 0.0f)
+        _body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
+    else
+        _body->setCollisionFlags(_body->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT);
+
+    if (added)
+        controller->addCollisionObject(this);
+    _body->activate(true);
+}
+
 void PhysicsRigidBody::setEnabled(bool enable)
 {
     PhysicsCollisionObject::setEnabled(enable);
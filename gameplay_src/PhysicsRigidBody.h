@@ -334,6 +334,28 @@ public:
     void forceActivation(int state);
     int getActivation();
 
+    /**
+     * Rebuilds the collision shape from the given definition at the node's current world scale,
+     * keeping this body and any constraints attached to it. The inertia, center of mass offset
+     * and broadphase bounds are updated to match.
+     *
+     * @param shape The definition to build the new shape from.
+     */
+    void updateShape(const PhysicsCollisionShape::Definition& shape);
+
+    /**
+     * Moves the body to its node's current transform while it stays in the world, eg. to put
+     * a dynamic body back where it was. Velocities are left as they are.
+     */
+    void syncTransform();
+
+    /**
+     * Changes the body's mass in place, keeping its constraints. A mass of zero makes it static.
+     *
+     * @param mass The new mass.
+     */
+    void setMass(float mass);
+
     /**
      * Sets whether the rigid body is enabled or disabled in the physics world.
      *
@@ -436,6 +458,9 @@ private:
     // Removes a constraint from this rigid body (used by the constraint destructor).
     void removeConstraint(PhysicsConstraint* constraint);
 
+    // Moves this body's end of a constraint by an offset in center of mass space.
+    void shiftConstraintFrame(PhysicsConstraint* constraint, const Vector3& shift);
+
     // Whether or not the rigid body supports constraints fully.
     bool supportsConstraints();
 
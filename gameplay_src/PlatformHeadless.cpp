@@ -0,0 +1,283 @@
+// Platform for T4T's headless runtime: no window, no GL context, no input. The game is started, runs its
+// headless initialize (which builds the projects and steps the physics) and the message pump returns once it exits.
+// Build the engine and game with GP_NO_PLATFORM and T4T_HEADLESS defined to use this in place of the desktop platforms.
+// Nothing here or in the game calls into a GL driver - the few GL entry points the engine's startup uses are defined below.
+#if defined(GP_NO_PLATFORM) && defined(T4T_HEADLESS)
+
+#include "Base.h"
+#include "Platform.h"
+#include "FileSystem.h"
+#include "Game.h"
+#include <unistd.h>
+#include <time.h>
+#include <strings.h>
+
+using namespace std;
+
+int __argc = 0;
+char** __argv = 0;
+
+static double __timeStart;
+static double __timeAbsolute;
+static bool __vsync = false;
+static bool __multiSampling = false;
+static bool __multiTouch = false;
+static bool __shutdown = false;
+
+static double getMonotonicTime()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char** argv)
+{
+    __argc = argc;
+    __argv = argv;
+    gameplay::Game* game = gameplay::Game::getInstance();
+    gameplay::Platform* platform = gameplay::Platform::create(game);
+    GP_ASSERT(platform);
+    int result = platform->enterMessagePump();
+    delete platform;
+    return result;
+}
+
+namespace gameplay
+{
+
+extern void print(const char* format, ...)
+{
+    GP_ASSERT(format);
+    va_list argptr;
+    va_start(argptr, format);
+    vfprintf(stderr, format, argptr);
+    va_end(argptr);
+}
+
+extern int strcmpnocase(const char* s1, const char* s2)
+{
+    return strcasecmp(s1, s2);
+}
+
+Platform::Platform(Game* game) : _game(game)
+{
+}
+
+Platform::~Platform()
+{
+}
+
+Platform* Platform::create(Game* game)
+{
+    Platform* platform = new Platform(game);
+    return platform;
+}
+
+int Platform::enterMessagePump()
+{
+    __timeStart = getMonotonicTime();
+    __timeAbsolute = 0;
+
+    // The game does all of its work while starting up - keep frames going only if it has not asked to exit yet.
+    if (_game->getState() == Game::UNINITIALIZED)
+        _game->run();
+    while (!__shutdown && _game->getState() != Game::UNINITIALIZED)
+        _game->frame();
+    return EXIT_SUCCESS;
+}
+
+void Platform::signalShutdown()
+{
+    __shutdown = true;
+}
+
+bool Platform::canExit()
+{
+    return true;
+}
+
+unsigned int Platform::getDisplayWidth()
+{
+    // Nothing is displayed, but the game divides by the viewport size when setting up cameras.
+    return 1;
+}
+
+unsigned int Platform::getDisplayHeight()
+{
+    return 1;
+}
+
+double Platform::getAbsoluteTime()
+{
+    __timeAbsolute = getMonotonicTime() - __timeStart;
+    return __timeAbsolute;
+}
+
+void Platform::setAbsoluteTime(double time)
+{
+    __timeAbsolute = time;
+}
+
+bool Platform::isVsync()
+{
+    return __vsync;
+}
+
+void Platform::setVsync(bool enable)
+{
+    __vsync = enable;
+}
+
+void Platform::swapBuffers()
+{
+}
+
+void Platform::sleep(long ms)
+{
+    usleep(ms * 1000);
+}
+
+bool Platform::hasAccelerometer()
+{
+    return false;
+}
+
+void Platform::getAccelerometerValues(float* pitch, float* roll)
+{
+    if (pitch)
+        *pitch = 0.0f;
+    if (roll)
+        *roll = 0.0f;
+}
+
+void Platform::getSensorValues(float* accelX, float* accelY, float* accelZ, float* gyroX, float* gyroY, float* gyroZ)
+{
+    float* values[6] = {accelX, accelY, accelZ, gyroX, gyroY, gyroZ};
+    for (int i = 0; i < 6; ++i)
+    {
+        if (values[i])
+            *values[i] = 0.0f;
+    }
+}
+
+void Platform::getArguments(int* argc, char*** argv)
+{
+    if (argc)
+        *argc = __argc;
+    if (argv)
+        *argv = __argv;
+}
+
+bool Platform::hasMouse()
+{
+    return false;
+}
+
+void Platform::setMouseCaptured(bool captured)
+{
+    // not supported
+}
+
+bool Platform::isMouseCaptured()
+{
+    return false;
+}
+
+void Platform::setCursorVisible(bool visible)
+{
+    // not supported
+}
+
+bool Platform::isCursorVisible()
+{
+    return false;
+}
+
+void Platform::setMultiSampling(bool enabled)
+{
+    __multiSampling = enabled;
+}
+
+bool Platform::isMultiSampling()
+{
+    return __multiSampling;
+}
+
+void Platform::setMultiTouch(bool enabled)
+{
+    __multiTouch = enabled;
+}
+
+bool Platform::isMultiTouch()
+{
+    return __multiTouch;
+}
+
+void Platform::displayKeyboard(bool display)
+{
+    // not supported
+}
+
+void Platform::shutdownInternal()
+{
+    Game::getInstance()->shutdown();
+}
+
+bool Platform::isGestureSupported(Gesture::GestureEvent evt)
+{
+    return false;
+}
+
+void Platform::registerGesture(Gesture::GestureEvent evt)
+{
+}
+
+void Platform::unregisterGesture(Gesture::GestureEvent evt)
+{
+}
+
+bool Platform::isGestureRegistered(Gesture::GestureEvent evt)
+{
+    return false;
+}
+
+void Platform::pollGamepadState(Gamepad* gamepad)
+{
+}
+
+bool Platform::launchURL(const char *url)
+{
+    return false;
+}
+
+std::string Platform::displayFileDialog(size_t mode, const char* title, const char* filterDescription, const char* filterExtensions, const char* initialDirectory)
+{
+    return "";
+}
+
+}
+
+// Game::startup still sets the viewport and FrameBuffer::initialize reads the default framebuffer binding. With no
+// context those calls have nowhere to go, so this build defines them itself and the driver is never entered.
+extern "C"
+{
+
+void GLAPIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+}
+
+void GLAPIENTRY glGetIntegerv(GLenum pname, GLint* params)
+{
+    if (params)
+        *params = 0;
+}
+
+GLenum GLAPIENTRY glGetError()
+{
+    return GL_NO_ERROR;
+}
+
+}
+
+#endif
@@ -11,7 +11,7 @@ Buggy::Buggy() : Project::Project("buggy", "Lunar Buggy") {
 	_rearAxle = addElement(new Axle(this, _body, "rearAxle", "Rear Axle"));
 	_frontWheels = addElement(new Wheels(this, _frontAxle, "frontWheels", "Front Wheels"));
 	_rearWheels = addElement(new Wheels(this, _rearAxle, "rearWheels", "Rear Wheels"));
-	setupMenu();
+	if(!app->_headless) setupMenu();
 
 	_finishDistance = 10;
 
@@ -57,11 +57,11 @@ bool Buggy::setSubMode(short mode) {
 void Buggy::setRampHeight(float scale) {
 	//cout << "scaling ramp to " << scale << endl;
 	_rampSlope = scale * 5.0f / 15.0f;
-	_ramp->removePhysics();
+	_launchSnapshot.clear(); //the buggy is about to be moved
 	_ramp->setScaleY(scale);
 	_ramp->setTranslationY(0); //(scale - 1) * 2.5f);
 	_ramp->updateTransform();
-	_ramp->addPhysics();
+	_ramp->updateCollisionShape();
 	//position the buggy near the top of the ramp
 	_rootNode->updateTransform();
 	BoundingBox box = _rootNode->getBoundingBox(true);
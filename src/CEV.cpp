@@ -9,7 +9,8 @@ CEV::CEV() : Project::Project("CEV", "Crew Exploration Vehicle") {
 	_body = (Body*) addElement(new Body(this));
 	_seat = (Seat*) addElement(new Seat(this, _body));
 	_hatch = (Hatch*) addElement(new Hatch(this, _body));
-	setupMenu();
+	_hatchButton = NULL;
+	if(!app->_headless) setupMenu();
 
     _showGround = false;
 
@@ -76,20 +77,20 @@ bool CEV::setSubMode(short mode) {
 			}
 			if(maxRadius > _maxRadius || (maxZ - minZ) > _maxLength) {
 				app->message("Your vehicle does not fit in the tube. Click 'Build' to fix it.");
-				_launchButton->setEnabled(false);
+				if(_launchButton) _launchButton->setEnabled(false);
 				break;
 			}
 			//check that the mass is within the limit
 			if(_rootNode->getMass() > _maxMass) {
 				app->message("Your vehicle is more than 100g. Click 'Build' to fix it.");
-				_launchButton->setEnabled(false);
+				if(_launchButton) _launchButton->setEnabled(false);
 				break;
 			}
 			app->message("Your vehicle is small enough. Now build the Launcher to test it out!");
 			break;
 		}
 	}
-	if(changed) _hatchButton->setEnabled(false);
+	if(changed && _hatchButton) _hatchButton->setEnabled(false);
 	_body->_groundAnchor.reset();
 	return changed;
 }
@@ -343,7 +343,8 @@ void HullMode::updateModel() {
 	//use the physical mesh, not the visual mesh, when making hulls
 	Meshy *visual = _hullNode->_visualMesh;
 	_hullNode->_visualMesh = NULL;
-	_hullNode->updateModel(true, false);
+	//one vertex per triangle corner, in face order, so we can index the triangles ourselves
+	_hullNode->updateModel(true, false, false, false);
 	_hullNode->_visualMesh = visual;
 
 	//add all the triangles again, but with opposite orientation, so the user can click on the backwards ones to reverse them
@@ -366,8 +367,12 @@ void HullMode::updateModel() {
 	part->setIndexData(&forward[0], 0, nt * 3);
 	part = model->getMesh()->addPart(Mesh::TRIANGLES, Mesh::INDEX16, nt * 3);
 	part->setIndexData(&reverse[0], 0, nt * 3);
-	model->setMaterial("res/common/models.material#hull_outer", 0);
-	model->setMaterial("res/common/models.material#hull_inner", 1);
+	Material *outer = app->createMaterial("hull_outer"), *inner = app->createMaterial("hull_inner");
+	model->setMaterial(outer, 0);
+	model->setMaterial(inner, 1);
+	SAFE_RELEASE(outer);
+	SAFE_RELEASE(inner);
+	_hullNode->_lightNode = NULL;
 }
 
 bool HullMode::keyEvent(Keyboard::KeyEvent evt, int key) {
@@ -31,7 +31,8 @@ LandingPod::LandingPod() : Project::Project("landingPod", "Landing Pod") {
 	_ramp->setVisible(false);
 	_scene->addNode(_ramp);
 
-	setupMenu();
+	_hatchButton = NULL;
+	if(!app->_headless) setupMenu();
 }
 
 void LandingPod::setupMenu() {
@@ -126,6 +127,7 @@ bool LandingPod::setSubMode(short mode) {
     
 void LandingPod::setButtons() {
     Project::setButtons();
+    if(!_hatchButton) return;
     _hatchButton->setVisible(_subMode == 1);
     _hatchButton->setEnabled(_launchComplete);
 }
@@ -166,6 +168,12 @@ void LandingPod::launch() {
 	//_hatchButton->setEnabled(true);
 }
 
+void LandingPod::relaunch() {
+	if(_body->_groundAnchor.get()) _body->_groundAnchor.reset();
+	_hatching = false;
+	Project::relaunch();
+}
+
 void LandingPod::launchComplete() {
 	Project::launchComplete();
 	if(!_broken) {
@@ -173,12 +181,15 @@ void LandingPod::launchComplete() {
 	}
 }
 
-void LandingPod::update() {
-	Project::update();
+void LandingPod::physicsTick(float timeStep) {
+	Project::physicsTick(timeStep);
 	if(_launching && _launchSteps == 100) {
-		_rootNode->setActivation(ACTIVE_TAG, true);
 		if(_payload) _payload->setActivation(ACTIVE_TAG, true);
 	}
+}
+
+void LandingPod::update() {
+	Project::update();
 	if(_hatching) {
 		_payload->updateTransform();
 		float maxZ = _payload->getMaxValue(Vector3::unitZ()) + _payload->getTranslationWorld().z;
@@ -42,7 +42,9 @@ public:
     void setButtons();
 	bool positionPayload();
 	void launch();
+	void relaunch();
 	void update();
+	void physicsTick(float timeStep);
 	void launchComplete();
 	void openHatch();
 };
@@ -11,7 +11,7 @@ Launcher::Launcher() : Project::Project("launcher", "CEV Launcher") {
 	app->addItem("rubberBand2", 1, "launcherBand");
 
 	_rubberBand = (RubberBand*) addElement(new RubberBand(this));
-	setupMenu();
+	if(!app->_headless) setupMenu();
 
 	_finishDistance = 15;
 
@@ -50,7 +50,7 @@ Launcher::Launcher() : Project::Project("launcher", "CEV Launcher") {
 	_cevBox = BoundingBox::empty();
 
 	_astronaut = app->duplicateModelNode("astronaut");
-	_astronautBox = _astronaut->getModel()->getMesh()->getBoundingBox();
+	_astronautBox = _astronaut->getMeshBox();
 	_astronaut->addPhysics();
 	_astronaut->enablePhysics(false);
 }
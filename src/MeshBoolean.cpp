@@ -0,0 +1,725 @@
+#include "T4TApp.h"
+#include "MeshBoolean.h"
+#include <cfloat>
+#include <algorithm>
+
+namespace T4T {
+
+/************ EXACT ARITHMETIC ************/
+
+//error-free transformations - x is the rounded result and y the rounding error
+static inline void twoSum(double a, double b, double &x, double &y) {
+	x = a + b;
+	double bv = x - a, av = x - bv;
+	y = (a - av) + (b - bv);
+}
+
+static inline void twoProduct(double a, double b, double &x, double &y) {
+	x = a * b;
+	y = std::fma(a, b, -x);
+}
+
+//add b to a nonoverlapping expansion, smallest component first (Shewchuk's Grow-Expansion with zero elimination)
+static void growExpansion(std::vector<double> &e, double b) {
+	double q = b, sum, err;
+	short n = 0, i;
+	for(i = 0; i < e.size(); i++) {
+		twoSum(q, e[i], sum, err);
+		q = sum;
+		if(err != 0) e[n++] = err;
+	}
+	e.resize(n);
+	if(q != 0) e.push_back(q);
+}
+
+//exact product of k doubles, as a list of terms that sum to it
+static void productTerms(const double *f, short k, std::vector<double> &terms) {
+	double x, y;
+	terms.assign(1, f[0]);
+	for(short i = 1; i < k; i++) {
+		short n = terms.size();
+		for(short j = 0; j < n; j++) {
+			twoProduct(terms[j], f[i], x, y);
+			terms[j] = x;
+			terms.push_back(y);
+		}
+	}
+}
+
+//sign of a k x k determinant (k <= 4), summing every term of the Leibniz formula exactly
+static short exactDetSign(const double m[4][4], short k) {
+	short perm[4] = {0, 1, 2, 3}, i, j, inversions;
+	std::vector<double> sum, terms;
+	double f[4];
+	do {
+		for(i = 0, inversions = 0; i < k; i++) for(j = i+1; j < k; j++) if(perm[i] > perm[j]) inversions++;
+		for(i = 0; i < k; i++) f[i] = m[i][perm[i]];
+		if(inversions % 2 == 1) f[0] = -f[0];
+		productTerms(f, k, terms);
+		for(j = 0; j < terms.size(); j++) growExpansion(sum, terms[j]);
+	} while(std::next_permutation(perm, perm + k));
+	//the largest component of a nonoverlapping expansion decides its sign
+	return sum.empty() ? 0 : sum.back() > 0 ? 1 : -1;
+}
+
+//filtered determinants: the double result is trusted unless it is within its worst-case rounding error of zero
+static short det3Sign(const double m[4][4]) {
+	double c0 = m[1][1]*m[2][2] - m[1][2]*m[2][1], c1 = m[1][0]*m[2][2] - m[1][2]*m[2][0],
+	  c2 = m[1][0]*m[2][1] - m[1][1]*m[2][0],
+	  det = m[0][0]*c0 - m[0][1]*c1 + m[0][2]*c2,
+	  permanent = fabs(m[0][0]) * (fabs(m[1][1]*m[2][2]) + fabs(m[1][2]*m[2][1]))
+	    + fabs(m[0][1]) * (fabs(m[1][0]*m[2][2]) + fabs(m[1][2]*m[2][0]))
+	    + fabs(m[0][2]) * (fabs(m[1][0]*m[2][1]) + fabs(m[1][1]*m[2][0])),
+	  bound = 8 * DBL_EPSILON * permanent;
+	if(det > bound) return 1;
+	if(det < -bound) return -1;
+	return exactDetSign(m, 3);
+}
+
+static short det4Sign(const double m[4][4]) {
+	//Laplace expansion by the 2x2 minors of the top and bottom row pairs
+	double s[6], c[6], sa[6], ca[6];
+	short pairs[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}}, i, a, b;
+	for(i = 0; i < 6; i++) {
+		a = pairs[i][0];
+		b = pairs[i][1];
+		s[i] = m[0][a]*m[1][b] - m[0][b]*m[1][a];
+		c[i] = m[2][a]*m[3][b] - m[2][b]*m[3][a];
+		sa[i] = fabs(m[0][a]*m[1][b]) + fabs(m[0][b]*m[1][a]);
+		ca[i] = fabs(m[2][a]*m[3][b]) + fabs(m[2][b]*m[3][a]);
+	}
+	double det = s[0]*c[5] - s[1]*c[4] + s[2]*c[3] + s[3]*c[2] - s[4]*c[1] + s[5]*c[0],
+	  permanent = sa[0]*ca[5] + sa[1]*ca[4] + sa[2]*ca[3] + sa[3]*ca[2] + sa[4]*ca[1] + sa[5]*ca[0],
+	  bound = 16 * DBL_EPSILON * permanent;
+	if(det > bound) return 1;
+	if(det < -bound) return -1;
+	return exactDetSign(m, 4);
+}
+
+static inline void cross(const double *u, const double *v, double *w) {
+	w[0] = u[1]*v[2] - u[2]*v[1];
+	w[1] = u[2]*v[0] - u[0]*v[2];
+	w[2] = u[0]*v[1] - u[1]*v[0];
+}
+
+static inline double dot(const double *u, const double *v) {
+	return u[0]*v[0] + u[1]*v[1] + u[2]*v[2];
+}
+
+/************ PLANES ************/
+
+MeshBoolean::MeshBoolean() : _extent(1), _output(NULL), _cancel(NULL), _weldDistance(1e-5f), _weldFirst(0) {
+}
+
+//forget all planes and polygons - the lists keep their storage for the next cut
+void MeshBoolean::clear() {
+	_planes.clear();
+	_bounds.clear();
+	_edgePoints.clear();
+	_output = NULL;
+}
+
+//size the stand-in polygons for whole planes to comfortably cover the model
+void MeshBoolean::setExtent(const std::vector<Vector3> &vertices) {
+	BoundingBox box;
+	short n = vertices.size(), i;
+	if(n > 0) box.set(vertices[0], vertices[0]);
+	for(i = 1; i < n; i++) box.merge(BoundingBox(vertices[i], vertices[i]));
+	_center = box.getCenter();
+	_extent = 2 * (box.max - box.min).length() + 1;
+	_weldDistance = 1e-5f * _extent;
+}
+
+int MeshBoolean::addPlane(double a, double b, double c, double d) {
+	int n = _planes.size();
+	CutPlane plane = {a, b, c, d}, opposite = {-a, -b, -c, -d};
+	_planes.push_back(plane);
+	_planes.push_back(opposite);
+	return n;
+}
+
+int MeshBoolean::addPlane(const Plane &plane) {
+	Vector3 normal = plane.getNormal();
+	return addPlane(normal.x, normal.y, normal.z, plane.getDistance());
+}
+
+int MeshBoolean::flip(int plane) {
+	return plane ^ 1;
+}
+
+int MeshBoolean::bound(const CutPolygon &poly, short i) {
+	return _bounds[poly.first + i];
+}
+
+bool MeshBoolean::sameDirection(int plane1, int plane2) {
+	const CutPlane &p = _planes[plane1], &q = _planes[plane2];
+	return p.a*q.a + p.b*q.b + p.c*q.c > 0;
+}
+
+/************ PREDICATES ************/
+
+//which side of the plane a polygon vertex is on: 1 = front, -1 = back, 0 = on it
+short MeshBoolean::side(const CutPolygon &poly, unsigned short vertex, int plane) {
+	short n = poly.count, i;
+	int defining[3] = {poly.support, bound(poly, (vertex+n-1)%n), bound(poly, vertex)};
+	for(i = 0; i < 3; i++) if(defining[i] >> 1 == plane >> 1) return 0;
+	//for the point where planes p1, p2, p3 meet, P(x) = det[p1 p2 p3 P] / det[n1 n2 n3]
+	double m[4][4];
+	for(i = 0; i < 4; i++) {
+		const CutPlane &p = _planes[i < 3 ? defining[i] : plane];
+		m[i][0] = p.a;
+		m[i][1] = p.b;
+		m[i][2] = p.c;
+		m[i][3] = p.d;
+	}
+	return det4Sign(m) * det3Sign(m);
+}
+
+//side of an explicit point, eg. an original mesh vertex
+short MeshBoolean::pointSide(const Vector3 &point, int plane) {
+	const CutPlane &p = _planes[plane];
+	double f[4] = {p.a * point.x, p.b * point.y, p.c * point.z, p.d},
+	  value = f[0] + f[1] + f[2] + f[3], bound = 4 * DBL_EPSILON * (fabs(f[0]) + fabs(f[1]) + fabs(f[2]) + fabs(f[3]));
+	if(value > bound) return 1;
+	if(value < -bound) return -1;
+	std::vector<double> sum;
+	double x, y, coords[3] = {point.x, point.y, point.z}, coeffs[3] = {p.a, p.b, p.c};
+	for(short i = 0; i < 3; i++) {
+		twoProduct(coeffs[i], coords[i], x, y);
+		growExpansion(sum, x);
+		growExpansion(sum, y);
+	}
+	growExpansion(sum, p.d);
+	return sum.empty() ? 0 : sum.back() > 0 ? 1 : -1;
+}
+
+//split a polygon by a plane: 1 = wholly in front, -1 = wholly behind, 0 = lies in the plane,
+//2 = spans it, with the two parts in front and back
+short MeshBoolean::split(const CutPolygon &poly, int plane, CutPolygon &front, CutPolygon &back) {
+	short n = poly.count, i, numFront = 0, numBack = 0, s1, s2;
+	_sides.resize(n);
+	for(i = 0; i < n; i++) {
+		_sides[i] = side(poly, i, plane);
+		if(_sides[i] > 0) numFront++;
+		else if(_sides[i] < 0) numBack++;
+	}
+	if(numFront == 0 && numBack == 0) return 0;
+	if(numBack == 0) return 1;
+	if(numFront == 0) return -1;
+	front.support = back.support = poly.support;
+	front.tag = back.tag = poly.tag;
+	//walk the edges - edge i runs from vertex i to vertex i+1 along bound i - and close each part with the
+	//cut plane where its boundary leaves the part; no new coordinates are made, only a new bounding plane
+	//the front part goes straight onto the bound list and the back part follows it, so each is one run
+	front.first = _bounds.size();
+	_backBounds.clear();
+	for(i = 0; i < n; i++) {
+		int b = bound(poly, i);
+		s1 = _sides[(i+1)%n];
+		s2 = _sides[(i+2)%n];
+		if(_sides[i] > 0 || s1 > 0) {
+			_bounds.push_back(b);
+			if(s1 < 0 || (s1 == 0 && s2 <= 0)) _bounds.push_back(flip(plane));
+		}
+		if(_sides[i] < 0 || s1 < 0) {
+			_backBounds.push_back(b);
+			if(s1 > 0 || (s1 == 0 && s2 >= 0)) _backBounds.push_back(plane);
+		}
+	}
+	front.count = _bounds.size() - front.first;
+	back.first = _bounds.size();
+	back.count = _backBounds.size();
+	_bounds.insert(_bounds.end(), _backBounds.begin(), _backBounds.end());
+	return 2;
+}
+
+/************ CONSTRUCTIONS ************/
+
+Vector3 MeshBoolean::getVertex(const CutPolygon &poly, unsigned short vertex) {
+	short n = poly.count, i;
+	const CutPlane *p[3] = {&_planes[poly.support], &_planes[bound(poly, (vertex+n-1)%n)], &_planes[bound(poly, vertex)]};
+	double normal[3][3], c[3][3], x[3];
+	for(i = 0; i < 3; i++) {
+		normal[i][0] = p[i]->a;
+		normal[i][1] = p[i]->b;
+		normal[i][2] = p[i]->c;
+	}
+	//Cramer's rule: x = -(d1 (n2 x n3) + d2 (n3 x n1) + d3 (n1 x n2)) / (n1 . (n2 x n3))
+	cross(normal[1], normal[2], c[0]);
+	cross(normal[2], normal[0], c[1]);
+	cross(normal[0], normal[1], c[2]);
+	double det = dot(normal[0], c[0]);
+	if(det == 0) return Vector3::zero();
+	for(i = 0; i < 3; i++) x[i] = -(p[0]->d * c[0][i] + p[1]->d * c[1][i] + p[2]->d * c[2][i]) / det;
+	return Vector3(x[0], x[1], x[2]);
+}
+
+Vector3 MeshBoolean::getCenter(const CutPolygon &poly) {
+	short n = poly.count, i;
+	Vector3 center = Vector3::zero();
+	for(i = 0; i < n; i++) center += getVertex(poly, i);
+	return center / n;
+}
+
+void MeshBoolean::getBox(const CutPolygon &poly, BoundingBox *box) {
+	short n = poly.count, i;
+	Vector3 v = getVertex(poly, 0);
+	box->set(v, v);
+	for(i = 1; i < n; i++) {
+		v = getVertex(poly, i);
+		box->merge(BoundingBox(v, v));
+	}
+}
+
+/************ POLYGONS ************/
+
+//convert a convex mesh face to a plane-based polygon - false if it is not convex or is degenerate
+bool MeshBoolean::facePolygon(const std::vector<Vector3> &vertices, const std::vector<unsigned short> &face, short tag,
+  CutPolygon &poly) {
+	short n = face.size(), i, j;
+	_ring.clear();
+	_points.clear();
+	for(i = 0; i < n; i++) {
+		const Vector3 &v = vertices[face[i]];
+		if(_ring.empty() || v != _ring.back()) _ring.push_back(v);
+	}
+	while(_ring.size() > 1 && _ring.front() == _ring.back()) _ring.pop_back();
+	Vector3 normal = Meshy::getNormal(_ring), e1, e2, turn;
+	if(_ring.size() < 3 || normal.lengthSquared() == 0) return false;
+	normal.normalize();
+	//drop vertices in the middle of a straight edge - their bounding planes would not meet in a point - but note
+	//which edge each one is on, counting from the corner before it
+	n = _ring.size();
+	_onEdge.clear();
+	for(i = 0; i < n; i++) {
+		e1 = _ring[i] - _ring[(i+n-1)%n];
+		e2 = _ring[(i+1)%n] - _ring[i];
+		Vector3::cross(e1, e2, &turn);
+		float sine = turn.dot(normal) / (e1.length() * e2.length());
+		if(sine < -1e-5f) return false;
+		if(sine > 1e-5f) _points.push_back(_ring[i]);
+		else _onEdge.push_back(std::make_pair((short)(_points.size() - 1), _ring[i]));
+	}
+	n = _points.size();
+	if(n < 3) return false;
+	Vector3 center = Vector3::zero();
+	for(i = 0; i < n; i++) center += _points[i];
+	center /= n;
+	double nd[3] = {normal.x, normal.y, normal.z}, edge[3], m[3], p[3];
+	poly.support = addPlane(nd[0], nd[1], nd[2], -(nd[0]*center.x + nd[1]*center.y + nd[2]*center.z));
+	poly.tag = tag;
+	poly.first = _bounds.size();
+	poly.count = n;
+	_bounds.resize(poly.first + n);
+	//edge plane normals point out of the face, so its interior is behind them
+	for(i = 0; i < n; i++) {
+		const Vector3 &v1 = _points[i], &v2 = _points[(i+1)%n];
+		edge[0] = (double)v2.x - v1.x;
+		edge[1] = (double)v2.y - v1.y;
+		edge[2] = (double)v2.z - v1.z;
+		cross(edge, nd, m);
+		p[0] = v1.x;
+		p[1] = v1.y;
+		p[2] = v1.z;
+		_bounds[poly.first + i] = addPlane(m[0], m[1], m[2], -dot(m, p));
+	}
+	for(i = 0; i < _onEdge.size(); i++) {
+		int pair = _bounds[poly.first + (_onEdge[i].first + n) % n] >> 1;
+		if(_edgePoints.size() <= pair) _edgePoints.resize(pair + 1);
+		_edgePoints[pair].push_back(_onEdge[i].second);
+	}
+	return true;
+}
+
+//a square covering the model's region of an unbounded plane, facing the same way as the plane
+void MeshBoolean::planePolygon(int plane, CutPolygon &poly) {
+	Vector3 normal(_planes[plane].a, _planes[plane].b, _planes[plane].c), axis, u, v;
+	normal.normalize();
+	//build the square's frame from the axis least aligned with the normal
+	float x = fabs(normal.x), y = fabs(normal.y), z = fabs(normal.z);
+	if(x <= y && x <= z) axis = Vector3::unitX();
+	else if(y <= z) axis = Vector3::unitY();
+	else axis = Vector3::unitZ();
+	Vector3::cross(normal, axis, &u);
+	u.normalize();
+	Vector3::cross(normal, u, &v);
+	Vector3 dirs[4] = {u, v, -u, -v};
+	poly.support = plane;
+	poly.tag = -1;
+	poly.first = _bounds.size();
+	poly.count = 4;
+	_bounds.resize(poly.first + 4);
+	for(short i = 0; i < 4; i++) {
+		_bounds[poly.first + i] = addPlane(dirs[i].x, dirs[i].y, dirs[i].z, -(dirs[i].dot(_center) + _extent));
+	}
+}
+
+//same region, facing the other way - in a run of its own, since copies of the polygon share the old one
+void MeshBoolean::invert(CutPolygon &poly) {
+	int first = _bounds.size();
+	for(short i = poly.count-1; i >= 0; i--) {
+		int b = bound(poly, i);
+		_bounds.push_back(b);
+	}
+	poly.support = flip(poly.support);
+	poly.first = first;
+}
+
+//boundary of the convex solid behind all the given planes
+void MeshBoolean::convexSolid(const std::vector<int> &planes, std::vector<CutPolygon> &polygons) {
+	short n = planes.size(), i, j;
+	CutPolygon poly, front, back;
+	for(i = 0; i < n; i++) {
+		planePolygon(planes[i], poly);
+		bool empty = false;
+		for(j = 0; j < n && !empty; j++) {
+			if(j == i) continue;
+			switch(split(poly, planes[j], front, back)) {
+				case 1: //wholly outside the solid
+					empty = true;
+					break;
+				case 2:
+					poly = back;
+					break;
+				case 0: //a repeated plane's face belongs to its first copy; an opposite one leaves no volume
+					empty = j < i || !sameDirection(planes[i], planes[j]);
+					break;
+			}
+		}
+		if(!empty) polygons.push_back(poly);
+	}
+}
+
+//the planes bounding a convex mesh, from its face planes in the working frame, dropping repeats
+void MeshBoolean::solidPlanes(const std::vector<Plane> &facePlanes, std::vector<int> &planes) {
+	short n = facePlanes.size(), i, j;
+	for(i = 0; i < n; i++) {
+		Vector3 normal = facePlanes[i].getNormal();
+		float distance = facePlanes[i].getDistance();
+		if(normal.lengthSquared() == 0) continue;
+		for(j = 0; j < planes.size(); j++) {
+			const CutPlane &p = _planes[planes[j]];
+			if(p.a*normal.x + p.b*normal.y + p.c*normal.z > 1 - 1e-5f && fabs(p.d - distance) < _weldDistance) break;
+		}
+		if(j == planes.size()) planes.push_back(addPlane(facePlanes[i]));
+	}
+}
+
+/************ BOOLEANS ************/
+
+//keep the parts of a polygon that are outside the convex tool
+void MeshBoolean::clipToTool(const CutPolygon &poly, const std::vector<int> &tool, std::vector<CutPolygon> &kept) {
+	CutPolygon rest = poly, front, back;
+	short n = tool.size(), i;
+	for(i = 0; i < n; i++) {
+		short result = split(rest, tool[i], front, back);
+		//lying on the tool surface: facing the same way as the tool plane, both the material and the tool are behind it,
+		//so it goes with the tool; facing the other way, it borders untouched material and stays
+		if(result == 0) result = sameDirection(rest.support, tool[i]) ? -1 : 1;
+		if(result == 1) {
+			kept.push_back(rest);
+			return;
+		}
+		if(result == 2) {
+			kept.push_back(front);
+			rest = back;
+		}
+	}
+	//whatever is behind every tool plane is inside the tool
+}
+
+//mesh minus the convex tool behind the given planes: faces clear of the tool are copied as they are, the rest are
+//clipped, and the tool surface inside the mesh closes the cut
+void MeshBoolean::subtract(Meshy *mesh, const std::vector<Vector3> &vertices, const std::vector<int> &tool, Meshy *result) {
+	beginOutput(result);
+	short nf = mesh->nf(), nt = tool.size(), i, j, k, n;
+	_remap.assign(vertices.size(), -1);
+	std::vector<CutPolygon> polys, kept;
+	CutPolygon poly;
+	for(i = 0; i < nf; i++) {
+		if(cancelled()) return;
+		Face &face = mesh->_faces[i];
+		n = face.size();
+		//a face wholly in front of any tool plane is clear of the tool
+		for(j = 0; j < nt; j++) {
+			for(k = 0; k < n && pointSide(vertices[face[k]], tool[j]) > 0; k++);
+			if(k == n) break;
+		}
+		if(j < nt) {
+			Face newFace(result);
+			newFace._border = face._border;
+			newFace._holes = face._holes;
+			newFace._triangles = face._triangles;
+			weldList(newFace._border, vertices, _remap);
+			for(j = 0; j < newFace._holes.size(); j++) weldList(newFace._holes[j], vertices, _remap);
+			for(j = 0; j < newFace._triangles.size(); j++) weldList(newFace._triangles[j], vertices, _remap);
+			result->addFace(newFace);
+			continue;
+		}
+		polys.clear();
+		if(!face.hasHoles() && facePolygon(vertices, face._border, i, poly)) polys.push_back(poly);
+		else for(j = 0; j < face.nt(); j++) {
+			if(facePolygon(vertices, face._triangles[j], i, poly)) polys.push_back(poly);
+		}
+		for(j = 0; j < polys.size(); j++) {
+			kept.clear();
+			clipToTool(polys[j], tool, kept);
+			addPolygons(kept);
+		}
+	}
+	if(!cancelled()) addCaps(mesh, vertices, tool);
+}
+
+//close the cut with the parts of the tool surface that are inside the mesh
+void MeshBoolean::addCaps(Meshy *mesh, const std::vector<Vector3> &vertices, const std::vector<int> &tool) {
+	std::vector<CutPolygon> toolFaces, fragments, next, covered;
+	std::vector<BoundingBox> boxes, nextBoxes;
+	std::vector<std::pair<Vector3, Vector3> > section;
+	std::vector<int> facePlanes(mesh->nf(), -1);
+	convexSolid(tool, toolFaces);
+	short nf = mesh->nf(), i, j, k, m, numSection, sides[3];
+	float value[3];
+	Vector3 point[2];
+	CutPolygon front, back, poly;
+	BoundingBox box, segmentBox;
+	for(i = 0; i < toolFaces.size(); i++) {
+		int plane = toolFaces[i].support;
+		CutPlane p = _planes[plane]; //a copy, since adding face planes below can move the list
+		//the cap faces into the tool, ie. out of what is left of the mesh
+		fragments.assign(1, toolFaces[i]);
+		invert(fragments[0]);
+		boxes.resize(1);
+		getBox(fragments[0], &boxes[0]);
+		section.clear();
+		covered.clear();
+		for(j = 0; j < nf; j++) {
+			if(cancelled()) return;
+			Face &face = mesh->_faces[j];
+			//the segments where this face's triangles cross the tool plane - which edges cross is decided exactly,
+			//and only the crossing points are constructed
+			numSection = section.size();
+			for(k = 0; k < face.nt(); k++) {
+				short numPoints = 0;
+				for(m = 0; m < 3; m++) {
+					const Vector3 &v = vertices[face._triangles[k][m]];
+					sides[m] = pointSide(v, plane);
+					value[m] = p.a * v.x + p.b * v.y + p.c * v.z + p.d;
+				}
+				//a mesh triangle in the tool plane facing out of the tool is kept by clipToTool, and already closes the cut there
+				if(sides[0] == 0 && sides[1] == 0 && sides[2] == 0) {
+					if(facePolygon(vertices, face._triangles[k], j, poly) && !sameDirection(poly.support, plane))
+						covered.push_back(poly);
+					continue;
+				}
+				for(m = 0; m < 3 && numPoints < 2; m++) {
+					float v1 = value[m], v2 = value[(m+1)%3];
+					if((sides[m] > 0) == (sides[(m+1)%3] > 0)) continue;
+					const Vector3 &a = vertices[face._triangles[k][m]], &b = vertices[face._triangles[k][(m+1)%3]];
+					//the float values can disagree with the exact sides right at the plane, so keep the point on the edge
+					float t = v1 != v2 ? v1 / (v1 - v2) : 0.5f;
+					point[numPoints++] = a + (b - a) * fmin(fmax(t, 0.0f), 1.0f);
+				}
+				if(numPoints == 2) section.push_back(std::make_pair(point[0], point[1]));
+			}
+			if(section.size() == numSection) continue;
+			//split the cap wherever this face crosses it
+			segmentBox.set(section[numSection].first, section[numSection].first);
+			for(k = numSection; k < section.size(); k++) {
+				segmentBox.merge(BoundingBox(section[k].first, section[k].first));
+				segmentBox.merge(BoundingBox(section[k].second, section[k].second));
+			}
+			segmentBox.min -= Vector3(_weldDistance, _weldDistance, _weldDistance);
+			segmentBox.max += Vector3(_weldDistance, _weldDistance, _weldDistance);
+			if(facePlanes[j] < 0) {
+				std::vector<Vector3> ring(face.size());
+				Vector3 center = Vector3::zero();
+				for(k = 0; k < face.size(); k++) {
+					ring[k] = vertices[face[k]];
+					center += ring[k];
+				}
+				center /= face.size();
+				Vector3 normal = Meshy::getNormal(ring);
+				normal.normalize();
+				facePlanes[j] = addPlane(normal.x, normal.y, normal.z, -normal.dot(center));
+			}
+			next.clear();
+			nextBoxes.clear();
+			for(k = 0; k < fragments.size(); k++) {
+				if(boxes[k].intersects(segmentBox) && split(fragments[k], facePlanes[j], front, back) == 2) {
+					next.push_back(front);
+					next.push_back(back);
+					nextBoxes.push_back(box);
+					getBox(front, &nextBoxes.back());
+					nextBoxes.push_back(box);
+					getBox(back, &nextBoxes.back());
+				} else {
+					next.push_back(fragments[k]);
+					nextBoxes.push_back(boxes[k]);
+				}
+			}
+			fragments.swap(next);
+			boxes.swap(nextBoxes);
+		}
+		//no fragment crosses the mesh surface now, so one point tells whether each is inside
+		for(k = 0; k < fragments.size(); k++) {
+			Vector3 center = getCenter(fragments[k]);
+			if(insideSection(center, plane, section) && !insidePolygons(center, covered)) addPolygon(fragments[k]);
+		}
+	}
+}
+
+//whether a point in a polygon's plane is inside any of the polygons
+bool MeshBoolean::insidePolygons(const Vector3 &point, const std::vector<CutPolygon> &polygons) {
+	short n = polygons.size(), i, j;
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < polygons[i].count && pointSide(point, bound(polygons[i], j)) <= 0; j++);
+		if(j == polygons[i].count) return true;
+	}
+	return false;
+}
+
+//whether a point in the plane is inside the mesh's cross-section there, by the parity of an in-plane ray
+//unlike the predicates above, this works in float on constructed crossing points - it is only asked about fragment
+//centers, which the exact splits keep away from every segment, so only a sliver fragment can be misjudged
+bool MeshBoolean::insideSection(const Vector3 &point, int plane, const std::vector<std::pair<Vector3, Vector3> > &section) {
+	const CutPlane &p = _planes[plane];
+	Vector3 normal(p.a, p.b, p.c), dir, perp;
+	//skew the ray so it is unlikely to run through a segment endpoint
+	Vector3::cross(normal, Vector3(0.5377f, 0.2618f, 0.8006f), &dir);
+	if(dir.lengthSquared() < 1e-6f * normal.lengthSquared()) Vector3::cross(normal, Vector3(0.8006f, 0.5377f, 0.2618f), &dir);
+	Vector3::cross(dir, normal, &perp);
+	short crossings = 0, n = section.size(), i;
+	for(i = 0; i < n; i++) {
+		const Vector3 &a = section[i].first, &b = section[i].second;
+		float sa = perp.dot(a - point), sb = perp.dot(b - point);
+		if((sa > 0) == (sb > 0)) continue;
+		Vector3 hit = a + (b - a) * (sa / (sa - sb));
+		if(dir.dot(hit - point) > 0) crossings++;
+	}
+	return crossings % 2 == 1;
+}
+
+//break a convex solid into the convex pieces outside the convex tool - piece i is outside tool plane i
+//and inside all the tool planes before it, so the pieces do not overlap
+void MeshBoolean::subtractConvex(const std::vector<int> &solid, const std::vector<int> &tool,
+  std::vector<std::vector<CutPolygon> > &pieces) {
+	short n = tool.size(), i, j;
+	std::vector<int> planes;
+	for(i = 0; i < n; i++) {
+		planes = solid;
+		planes.push_back(flip(tool[i]));
+		for(j = 0; j < i; j++) planes.push_back(tool[j]);
+		pieces.push_back(std::vector<CutPolygon>());
+		convexSolid(planes, pieces.back());
+		if(pieces.back().size() < 4) pieces.pop_back();
+	}
+}
+
+/************ OUTPUT ************/
+
+void MeshBoolean::beginOutput(Meshy *result) {
+	_output = result;
+	_weldHead.assign(64, -1);
+	_weldFirst = result->nv();
+}
+
+//index of the output vertex at this point, merging points that different plane triples put in the same place
+unsigned short MeshBoolean::weld(const Vector3 &v) {
+	long long cell[3] = {(long long)floor(v.x / _weldDistance), (long long)floor(v.y / _weldDistance),
+	  (long long)floor(v.z / _weldDistance)}, key;
+	short i, j, k;
+	int m;
+	for(i = -1; i <= 1; i++) for(j = -1; j <= 1; j++) for(k = -1; k <= 1; k++) {
+		key = ((cell[0]+i) * 73856093LL) ^ ((cell[1]+j) * 19349663LL) ^ ((cell[2]+k) * 83492791LL);
+		for(m = _weldHead[key & (_weldHead.size()-1)]; m >= 0; m = _weldNext[m]) {
+			if(_weldKey[m] == key && _output->_vertices[m].distanceSquared(v) <= _weldDistance * _weldDistance) return m;
+		}
+	}
+	unsigned short n = _output->nv();
+	_output->addVertex(v);
+	if(_weldNext.size() <= n) {
+		_weldNext.resize(n+1);
+		_weldKey.resize(n+1);
+	}
+	_weldKey[n] = (cell[0] * 73856093LL) ^ (cell[1] * 19349663LL) ^ (cell[2] * 83492791LL);
+	//keep the table at most half full, rehashing the chains when it doubles
+	if(2 * (n+1 - _weldFirst) > _weldHead.size()) {
+		_weldHead.assign(2 * _weldHead.size(), -1);
+		for(m = _weldFirst; m < n; m++) weldLink(m);
+	}
+	weldLink(n);
+	return n;
+}
+
+void MeshBoolean::weldLink(unsigned short v) {
+	int &head = _weldHead[_weldKey[v] & (_weldHead.size()-1)];
+	_weldNext[v] = head;
+	head = v;
+}
+
+//point a list of source vertex indices at the output vertices
+void MeshBoolean::weldList(std::vector<unsigned short> &list, const std::vector<Vector3> &vertices, std::vector<int> &remap) {
+	for(short i = 0; i < list.size(); i++) {
+		if(remap[list[i]] < 0) remap[list[i]] = weld(vertices[list[i]]);
+		list[i] = remap[list[i]];
+	}
+}
+
+void MeshBoolean::addPolygon(const CutPolygon &poly) {
+	short n = poly.count, i, j, k;
+	_face.clear();
+	for(i = 0; i < n; i++) {
+		Vector3 a = getVertex(poly, i);
+		unsigned short v = weld(a);
+		if(_face.empty() || v != _face.back()) _face.push_back(v);
+		//put back the source vertices inside this edge, so it meets the faces beside it without a T-junction
+		int plane = bound(poly, i) >> 1;
+		if(plane >= _edgePoints.size() || _edgePoints[plane].empty()) continue;
+		Vector3 edge = getVertex(poly, (i+1)%n) - a;
+		float length = edge.length();
+		if(length <= 2 * _weldDistance) continue;
+		_between.clear();
+		for(j = 0; j < _edgePoints[plane].size(); j++) {
+			float t = (_edgePoints[plane][j] - a).dot(edge) / (length * length);
+			if(t * length > _weldDistance && (1 - t) * length > _weldDistance) _between.push_back(std::make_pair(t, j));
+		}
+		std::sort(_between.begin(), _between.end());
+		for(j = 0; j < _between.size(); j++) {
+			v = weld(_edgePoints[plane][_between[j].second]);
+			if(v != _face.back()) _face.push_back(v);
+		}
+	}
+	while(_face.size() > 1 && _face.front() == _face.back()) _face.pop_back();
+	n = _face.size();
+	if(n < 3) return;
+	//fan from a corner - the slivers along its own two edges have no area, so they are left out
+	_triangles.resize(n-2);
+	Vector3 normal;
+	for(i = 0, k = 0; i < n-2; i++) {
+		const Vector3 &a = _output->_vertices[_face[0]], &b = _output->_vertices[_face[i+1]], &c = _output->_vertices[_face[i+2]];
+		Vector3::cross(b - a, c - a, &normal);
+		if(normal.lengthSquared() <= 1e-10f * (b - a).lengthSquared() * (c - a).lengthSquared()) continue;
+		_triangles[k].resize(3);
+		_triangles[k][0] = _face[0];
+		_triangles[k][1] = _face[i+1];
+		_triangles[k][2] = _face[i+2];
+		k++;
+	}
+	if(k == 0) return;
+	_triangles.resize(k);
+	_output->addFace(_face, _triangles);
+}
+
+void MeshBoolean::addPolygons(const std::vector<CutPolygon> &polygons) {
+	for(short i = 0; i < polygons.size(); i++) addPolygon(polygons[i]);
+}
+
+void MeshBoolean::setCancel(const std::atomic<bool> *cancel) {
+	_cancel = cancel;
+}
+
+bool MeshBoolean::cancelled() {
+	return _cancel != NULL && _cancel->load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,105 @@
+#ifndef MESHBOOLEAN_H_
+#define MESHBOOLEAN_H_
+
+#include "Meshy.h"
+#include <vector>
+#include <atomic>
+
+namespace T4T {
+
+//plane-based boolean kernel for cutting meshes with convex tools - saw half-space, drill prism, or any other bit
+//that is the region behind a set of planes.  A polygon is kept as its support plane plus one bounding plane per edge,
+//and each vertex is where the support plane meets two consecutive bounding planes, so splitting never rounds a
+//coordinate.  Every side test is a determinant of plane coefficients, evaluated in double precision and redone
+//exactly only when it is within rounding error of zero.
+class MeshBoolean {
+public:
+	//a*x + b*y + c*z + d = 0, positive side in front
+	struct CutPlane {
+		double a, b, c, d;
+	};
+	//convex polygon - its interior is behind all of its bounding planes, and vertex i is support/bound i-1/bound i
+	struct CutPolygon {
+		int support;
+		int first; //its bounding planes are _bounds[first] on, so a polygon copies without allocating
+		short count;
+		short tag; //face of the source mesh, or -1 for the tool surface
+	};
+
+	std::vector<CutPlane> _planes; //kept in opposite pairs, so the flip of plane p is p^1
+	std::vector<int> _bounds; //bounding planes of every polygon made since the last clear
+	Vector3 _center; //region the stand-in polygon for a whole plane has to cover
+	double _extent;
+
+	MeshBoolean();
+	void clear();
+	void setExtent(const std::vector<Vector3> &vertices);
+	int addPlane(double a, double b, double c, double d);
+	int addPlane(const Plane &plane);
+	static int flip(int plane);
+	int bound(const CutPolygon &poly, short i);
+
+	//exact predicates
+	short side(const CutPolygon &poly, unsigned short vertex, int plane);
+	short pointSide(const Vector3 &point, int plane);
+	short split(const CutPolygon &poly, int plane, CutPolygon &front, CutPolygon &back);
+
+	//constructions - only used for output, never fed back into a predicate
+	Vector3 getVertex(const CutPolygon &poly, unsigned short vertex);
+	Vector3 getCenter(const CutPolygon &poly);
+	void getBox(const CutPolygon &poly, BoundingBox *box);
+
+	//building polygons
+	bool facePolygon(const std::vector<Vector3> &vertices, const std::vector<unsigned short> &face, short tag,
+	  CutPolygon &poly);
+	void planePolygon(int plane, CutPolygon &poly);
+	void invert(CutPolygon &poly);
+	void convexSolid(const std::vector<int> &planes, std::vector<CutPolygon> &polygons);
+	void solidPlanes(const std::vector<Plane> &facePlanes, std::vector<int> &planes);
+
+	//boolean operations - vertices are the mesh's vertices in the tool's frame
+	void subtract(Meshy *mesh, const std::vector<Vector3> &vertices, const std::vector<int> &tool, Meshy *result);
+	void subtractConvex(const std::vector<int> &solid, const std::vector<int> &tool,
+	  std::vector<std::vector<CutPolygon> > &pieces);
+
+	//output
+	void beginOutput(Meshy *result);
+	unsigned short weld(const Vector3 &v);
+	void addPolygon(const CutPolygon &poly);
+	void addPolygons(const std::vector<CutPolygon> &polygons);
+
+	//lets another thread abandon a cut part way - the output is then incomplete and should be thrown away
+	void setCancel(const std::atomic<bool> *cancel);
+	bool cancelled();
+
+private:
+	Meshy *_output;
+	const std::atomic<bool> *_cancel;
+	float _weldDistance;
+	//output vertices hashed by weld cell - each bucket heads a chain through _weldNext, indexed by output vertex
+	std::vector<int> _weldHead, _weldNext;
+	std::vector<long long> _weldKey;
+	unsigned short _weldFirst;
+	//scratch kept between calls, so a cut is not spent in the allocator
+	std::vector<short> _sides;
+	std::vector<int> _remap, _backBounds;
+	std::vector<Vector3> _ring, _points;
+	std::vector<std::pair<short, Vector3> > _onEdge;
+	std::vector<std::pair<float, short> > _between;
+	//source vertices facePolygon dropped from the middle of an edge, by the edge's bounding plane pair - the faces
+	//beside that edge still use them, so they are put back wherever the edge is output
+	std::vector<std::vector<Vector3> > _edgePoints;
+	std::vector<unsigned short> _face;
+	std::vector<std::vector<unsigned short> > _triangles;
+	void weldLink(unsigned short v);
+	void weldList(std::vector<unsigned short> &list, const std::vector<Vector3> &vertices, std::vector<int> &remap);
+	void clipToTool(const CutPolygon &poly, const std::vector<int> &tool, std::vector<CutPolygon> &kept);
+	void addCaps(Meshy *mesh, const std::vector<Vector3> &vertices, const std::vector<int> &tool);
+	bool sameDirection(int plane1, int plane2);
+	bool insideSection(const Vector3 &point, int plane, const std::vector<std::pair<Vector3, Vector3> > &section);
+	bool insidePolygons(const Vector3 &point, const std::vector<CutPolygon> &polygons);
+};
+
+}
+
+#endif
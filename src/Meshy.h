@@ -113,8 +113,11 @@ public:
 	virtual void setNormals();
 	Vector3 getNormal(std::vector<unsigned short> &face, bool modelSpace = false);
 	static Vector3 getNormal(std::vector<Vector3> &face);
+	static void optimizeTriangleOrder(std::vector<unsigned int> &indices, unsigned int nv);
 	virtual void copyMesh(Meshy *mesh);
+	virtual void swapMesh(Meshy *mesh);
 	virtual void clearMesh();
+	virtual size_t getMemorySize();
 	bool loadMesh(Stream *stream);
 	void writeMesh(Stream *stream, bool modelSpace);
 	void loadObj(const char *filename, Vector3 *shift = NULL);
@@ -12,7 +12,7 @@ Mode::Mode(const char* id, const char *name) : _selectedNode(NULL), _doSelect(tr
 	app->splash(os.str().c_str());
 
 	_scene = app->_scene;
-	_camera = app->getCamera();
+	_camera = app->_activeScene ? app->getCamera() : NULL;
 	
 	_id = id;
 	_name = name ? name : "";
@@ -20,8 +20,10 @@ Mode::Mode(const char* id, const char *name) : _selectedNode(NULL), _doSelect(tr
 	setAutoSize(Control::AUTO_SIZE_BOTH);
 	setConsumeInputEvents(true);
 */
-	//add this button to the container it belongs in
-	_container = (Container*)app->_stage->getControl(("mode_" + _id).c_str());
+	//add this button to the container it belongs in - there is no UI when running headless
+	_container = app->_headless ? NULL : (Container*)app->_stage->getControl(("mode_" + _id).c_str());
+	_controls = NULL;
+	_subModePanel = NULL;
 	if(_container) {
 		_container->setVisible(false);
 
@@ -37,12 +39,15 @@ Mode::Mode(const char* id, const char *name) : _selectedNode(NULL), _doSelect(tr
 	}
 
 	_plane = app->_groundPlane;
-	_cameraBase = Camera::createPerspective(_camera->getFieldOfView(), _camera->getAspectRatio(),
-	  _camera->getNearPlane(), _camera->getFarPlane());
-	Node *cameraNode = Node::create((_id + "_camera").c_str());
-	cameraNode->setCamera(_cameraBase);
+	_cameraBase = NULL;
 	_cameraStateBase = new CameraState();
-	app->_cameraState->copy(_cameraStateBase);
+	if(_camera) {
+		_cameraBase = Camera::createPerspective(_camera->getFieldOfView(), _camera->getAspectRatio(),
+		  _camera->getNearPlane(), _camera->getFarPlane());
+		Node *cameraNode = Node::create((_id + "_camera").c_str());
+		cameraNode->setCamera(_cameraBase);
+	}
+	if(app->_cameraState) app->_cameraState->copy(_cameraStateBase);
 	//setActive(false);
 	_active = false;
 	_selectedNode = NULL;
@@ -63,7 +68,7 @@ void Mode::draw() {}
 void Mode::setActive(bool active) {
 	_active = active;
 	setSelectedNode(NULL);
-	_container->setVisible(active);
+	if(_container) _container->setVisible(active);
 	if(active) {
 		app->cameraPush();
 		app->setActiveScene(_scene);
@@ -296,12 +301,13 @@ void TouchPoint::set(Touch::TouchEvent evt, int x, int y, bool getNode) {
 		Camera *camera = app->getCamera();
 		Ray ray;
 		camera->pickRay(app->getViewport(), x, y, &ray);
-		PhysicsController::HitResult result;
-		_hit = app->getPhysicsController()->rayTest(ray, camera->getFarPlane(), &result, app->_hitFilter);
+		Vector3 point, normal;
+		MyNode *node = app->pickNode(ray, camera->getFarPlane(), &point, &normal);
+		_hit = node != NULL;
 		if(_hit) {
-			_node[evt] = dynamic_cast<MyNode*>(result.object->getNode());
-			_point[evt] = result.point;
-			_normal[evt] = result.normal;
+			_node[evt] = node;
+			_point[evt] = point;
+			_normal[evt] = normal;
 		}
 	}
 }
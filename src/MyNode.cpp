@@ -256,7 +256,7 @@ void Face::tessError(GLenum errno) {
 #endif
 
 
-Meshy::Meshy() {
+Meshy::Meshy() : _node(NULL) {
 }
 
 short Meshy::nv() {
@@ -456,7 +456,9 @@ void Meshy::updateTransform() {
 	_normalMatrix = _node->getInverseTransposeWorldMatrix();
 	unsigned short i, nv = _vertices.size(), nf = _faces.size();
 	_worldVertices.resize(nv);
-	_vInfo.resize(nv);
+#ifdef _DEBUG
+	_vInfo.resize(nv); //per-vertex notes are only for debug printing
+#endif
 	for(i = 0; i < nv; i++) _worldMatrix.transformPoint(_vertices[i], &_worldVertices[i]);
 	for(i = 0; i < nf; i++) _faces[i].updateTransform();
 }
@@ -509,6 +511,98 @@ Vector3 Meshy::getNormal(std::vector<Vector3> &face) {
     return normal;
 }
 
+//reorder triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+void Meshy::optimizeTriangleOrder(std::vector<unsigned int> &indices, unsigned int nv) {
+	const int cacheSize = 32;
+	unsigned int nt = indices.size() / 3, i, j, k, t, v;
+	if(nt < 2) return;
+	std::vector<int> cachePos(nv, -1), remaining(nv, 0), triStart(nv + 1, 0), vTris(nt * 3);
+	std::vector<float> vScore(nv), tScore(nt, 0);
+	std::vector<bool> added(nt, false);
+	//build vertex => triangle adjacency
+	for(i = 0; i < nt * 3; i++) remaining[indices[i]]++;
+	for(i = 0; i < nv; i++) triStart[i+1] = triStart[i] + remaining[i];
+	std::vector<int> fill(triStart.begin(), triStart.end() - 1);
+	for(i = 0; i < nt * 3; i++) vTris[fill[indices[i]]++] = i / 3;
+	//score a vertex by its cache position and how many triangles still need it
+	struct Scorer {
+		static float score(int pos, int tris) {
+			if(tris == 0) return -1.0f;
+			float score = 0;
+			if(pos >= 0) {
+				if(pos < 3) score = 0.75f;
+				else score = powf(1.0f - (pos - 3) * (1.0f / (cacheSize - 3)), 1.5f);
+			}
+			return score + 2.0f * powf(tris, -0.5f);
+		}
+	};
+	for(i = 0; i < nv; i++) vScore[i] = Scorer::score(-1, remaining[i]);
+	for(t = 0; t < nt; t++) for(k = 0; k < 3; k++) tScore[t] += vScore[indices[t*3 + k]];
+	std::vector<unsigned int> newIndices(nt * 3);
+	std::vector<int> cache, newCache;
+	int best = -1;
+	float bestScore;
+	unsigned int scan = 0;
+	for(i = 0; i < nt; i++) {
+		if(best < 0) { //nothing in the cache touches a remaining triangle - take the best one overall
+			bestScore = -1;
+			for(t = scan; t < nt; t++) {
+				if(added[t]) {
+					if(t == scan) scan++;
+					continue;
+				}
+				if(tScore[t] > bestScore) {
+					bestScore = tScore[t];
+					best = t;
+				}
+			}
+		}
+		t = best;
+		added[t] = true;
+		newCache.clear();
+		for(k = 0; k < 3; k++) {
+			v = indices[t*3 + k];
+			newIndices[i*3 + k] = v;
+			newCache.push_back(v);
+			//remove this triangle from the vertex's remaining list
+			for(j = triStart[v]; j < triStart[v] + remaining[v]; j++) {
+				if(vTris[j] == t) {
+					vTris[j] = vTris[triStart[v] + remaining[v] - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+		for(j = 0; j < cache.size(); j++) {
+			v = cache[j];
+			if(v != newCache[0] && v != newCache[1] && v != newCache[2]) newCache.push_back(v);
+		}
+		//rescore every vertex whose cache position changed, including those pushed out of the cache
+		for(j = 0; j < newCache.size(); j++) {
+			v = newCache[j];
+			cachePos[v] = j < cacheSize ? (int)j : -1;
+			float score = Scorer::score(cachePos[v], remaining[v]), diff = score - vScore[v];
+			vScore[v] = score;
+			for(k = triStart[v]; k < triStart[v] + remaining[v]; k++) tScore[vTris[k]] += diff;
+		}
+		if(newCache.size() > cacheSize) newCache.resize(cacheSize);
+		cache.swap(newCache);
+		//pick the next triangle from among those touching the cache
+		best = -1;
+		bestScore = -1;
+		for(j = 0; j < cache.size(); j++) {
+			v = cache[j];
+			for(k = triStart[v]; k < triStart[v] + remaining[v]; k++) {
+				if(tScore[vTris[k]] > bestScore) {
+					bestScore = tScore[vTris[k]];
+					best = vTris[k];
+				}
+			}
+		}
+	}
+	indices.swap(newIndices);
+}
+
 void Meshy::copyMesh(Meshy *src) {
 	_vertices = src->_vertices;
 	_vInfo = src->_vInfo;
@@ -518,6 +612,41 @@ void Meshy::copyMesh(Meshy *src) {
 	_edges = src->_edges;
 }
 
+//trade mesh data with another mesh instead of copying it - only the faces' back-pointers need fixing
+void Meshy::swapMesh(Meshy *mesh) {
+	_vertices.swap(mesh->_vertices);
+	_vInfo.swap(mesh->_vInfo);
+	_faces.swap(mesh->_faces);
+	_edgeInd.swap(mesh->_edgeInd);
+	_edges.swap(mesh->_edges);
+	short i;
+	for(i = 0; i < _faces.size(); i++) _faces[i]._mesh = this;
+	for(i = 0; i < mesh->_faces.size(); i++) mesh->_faces[i]._mesh = mesh;
+}
+
+//rough count of the bytes held by the mesh data - map entries are charged their tree node overhead
+size_t Meshy::getMemorySize() {
+	const size_t node = 4 * sizeof(void*);
+	size_t bytes = (_vertices.capacity() + _worldVertices.capacity()) * sizeof(Vector3)
+	  + _faces.capacity() * sizeof(Face) + _edges.capacity() * sizeof(std::vector<unsigned short>)
+	  + _vInfo.capacity() * sizeof(std::string);
+	short i, j;
+	for(i = 0; i < _faces.size(); i++) {
+		Face &face = _faces[i];
+		bytes += face._border.capacity() * sizeof(unsigned short)
+		  + (face._triangles.capacity() + face._holes.capacity()) * sizeof(std::vector<unsigned short>)
+		  + face._next.size() * (node + 2 * sizeof(unsigned short));
+		for(j = 0; j < face._triangles.size(); j++) bytes += face._triangles[j].capacity() * sizeof(unsigned short);
+		for(j = 0; j < face._holes.size(); j++) bytes += face._holes[j].capacity() * sizeof(unsigned short);
+	}
+	for(i = 0; i < _edges.size(); i++) bytes += _edges[i].capacity() * sizeof(unsigned short);
+	std::map<unsigned short, std::map<unsigned short, short> >::iterator it;
+	for(it = _edgeInd.begin(); it != _edgeInd.end(); it++) {
+		bytes += node + sizeof(*it) + it->second.size() * (node + sizeof(unsigned short) + sizeof(short));
+	}
+	return bytes;
+}
+
 void Meshy::clearMesh() {
 	_vertices.clear();
 	_faces.clear();
@@ -640,6 +769,27 @@ MyNode::MyNode(const char *id) : Node::Node(id), Meshy::Meshy()
 	init();
 }
 
+MyNode::~MyNode() {
+	app->unindexNode(this);
+	app->removeFromSceneTree(this);
+	if(_moveQueued) app->dequeueTransform(this);
+	//my constraint partners must not keep a handle to me
+	for(short i = 0; i < _constraints.size(); i++) {
+		MyNode *other = _constraints[i]->node;
+		if(!other) continue;
+		for(short j = 0; j < other->_constraints.size(); j++) {
+			if(other->_constraints[j]->node == this) other->_constraints[j]->node = NULL;
+		}
+	}
+}
+
+//hides Node::setId so the app's node index never holds an entry under a stale ID, and reindexes for the new one
+void MyNode::setId(const char *id) {
+	app->unindexNode(this);
+	Node::setId(id);
+	if(getScene()) app->invalidateNodeIndex();
+}
+
 MyNode* MyNode::create(const char *id) {
 	return new MyNode(id);
 }
@@ -652,6 +802,20 @@ void MyNode::init() {
     app = (T4TApp*) Game::getInstance();
     _staticObj = false;
     _boundingBox = BoundingBox::empty();
+    _worldBox = BoundingBox::empty();
+    _localBox = BoundingBox::empty();
+    _treeLeaf = -1;
+    _moveQueued = false;
+    _transformDirty = false;
+    _bodyDirty = false;
+    _treeEmpty = true;
+    _subtreeEmpty = true;
+    _supportEmpty = true;
+    _support = 0;
+    _boundsVersion = 1;
+    _treeBoxVersion = 0;
+    _subtreeBoxVersion = 0;
+    _supportVersion = 0;
     _groundRotation = Quaternion::identity();
     _userRotation = Quaternion::identity();
     _anchorRotation = Quaternion::identity();
@@ -667,6 +831,9 @@ void MyNode::init() {
     _wireframe = false;
     _lineWidth = 1.0f;
     _color.set(-1.0f, -1.0f, -1.0f, 1.0f); //indicates no color specified
+    _drawColor = _color;
+    _lightNode = NULL;
+    _renderParent = NULL;
     _objType = "none";
     _mass = 0;
     _radius = 0;
@@ -691,6 +858,7 @@ MyNode* MyNode::cloneNode(Node *node) {
 		copy->_wireframe = myNode->_wireframe;
 		copy->_lineWidth = myNode->_lineWidth;
 		copy->_color = myNode->_color;
+		copy->_drawColor = myNode->_drawColor;
 		if(myNode->_visualMesh) {
 			copy->_visualMesh = new Meshy();
 			copy->_visualMesh->_node = copy;
@@ -798,48 +966,117 @@ Matrix MyNode::getInverseWorldMatrix() {
 	return m;
 }
 
+//bounds of my own vertices as they are stored - the same box my model's mesh gets, but there is no model headless
+BoundingBox MyNode::getMeshBox() {
+	short n = _vertices.size(), i;
+	if(n == 0) return BoundingBox::empty();
+	Vector3 min = _vertices[0], max = _vertices[0];
+	for(i = 1; i < n; i++) {
+		const Vector3 &v = _vertices[i];
+		min.set(fmin(min.x, v.x), fmin(min.y, v.y), fmin(min.z, v.z));
+		max.set(fmax(max.x, v.x), fmax(max.y, v.y), fmax(max.z, v.z));
+	}
+	return BoundingBox(min, max);
+}
+
 BoundingBox MyNode::getBoundingBox(bool modelSpace, bool recur) {
 	Vector3 vec, min(1e6, 1e6, 1e6), max(-1e6, -1e6, -1e6);
-	std::vector<MyNode*> nodes;
-	if(recur) nodes = getAllNodes();
-	else nodes.push_back(this);
-	short n = nodes.size(), i, j, k;
-	Matrix m;
-	if(modelSpace) {
-		getWorldMatrix().invert(&m);
-		Matrix rot;
-		Matrix::createRotation(_groundRotation, &rot);
-		m = rot * m;
+	if(!modelSpace) {
+		//world boxes come straight from the caches
+		BoundingBox box = _worldBox;
+		bool hasVertices = recur ? getTreeBox(&box) : !_worldVertices.empty();
+		if(hasVertices) return box;
+		min.set(-_radius, -_radius, -_radius);
+		max.set(_radius, _radius, _radius);
+		return BoundingBox(min + getTranslationWorld(), max + getTranslationWorld());
 	}
-	bool hasVertices = false;
-	for(i = 0; i < n; i++) {
-		MyNode *node = nodes[i];
-		short nv = node->nv();
-		if(nv > 0) hasVertices = true;
-		for(j = 0; j < nv; j++) {
-			vec = node->_worldVertices[j];
-			if(modelSpace) m.transformPoint(&vec);
-			for(k = 0; k < 3; k++) {
-				MyNode::sv(min, k, fmin(MyNode::gv(min, k), MyNode::gv(vec, k)));
-				MyNode::sv(max, k, fmax(MyNode::gv(max, k), MyNode::gv(vec, k)));
-			}
-		}
+	//my own vertices are exact and need no world data, so this holds even while my moves are waiting on the next frame;
+	//each child's subtree comes from its cached box carried through its transform relative to me
+	Matrix rot;
+	Matrix::createRotation(_groundRotation, &rot);
+	short nv = this->nv(), j, k;
+	bool hasVertices = nv > 0;
+	for(j = 0; j < nv; j++) {
+		rot.transformPoint(_vertices[j], &vec);
+		for(k = 0; k < 3; k++) {
+			MyNode::sv(min, k, fmin(MyNode::gv(min, k), MyNode::gv(vec, k)));
+			MyNode::sv(max, k, fmax(MyNode::gv(max, k), MyNode::gv(vec, k)));
+		}
+	}
+	BoundingBox box(min, max), childBox;
+	if(recur) for(Node *child = getFirstChild(); child; child = child->getNextSibling()) {
+		MyNode *node = dynamic_cast<MyNode*>(child);
+		if(!node || !node->getSubtreeBox(&childBox)) continue;
+		childBox.transform(rot * node->getMatrix());
+		if(hasVertices) box.merge(childBox);
+		else box = childBox;
+		hasVertices = true;
 	}
 	if(!hasVertices) {
 		min.set(-_radius, -_radius, -_radius);
 		max.set(_radius, _radius, _radius);
-		if(!modelSpace) {
-			min += getTranslationWorld();
-			max += getTranslationWorld();
+		box.set(min, max);
+	}
+	return box;
+}
+
+//box of my vertices and all my descendants' in my model space, merged from my local box and my children's boxes
+//carried through their transforms relative to me - it can be looser than the vertices where a child is rotated
+bool MyNode::getSubtreeBox(BoundingBox *box) {
+	if(_subtreeBoxVersion != _boundsVersion) {
+		_subtreeEmpty = _localBox.isEmpty();
+		_subtreeBox = _localBox;
+		BoundingBox childBox;
+		for(Node *child = getFirstChild(); child; child = child->getNextSibling()) {
+			MyNode *node = dynamic_cast<MyNode*>(child);
+			if(!node || !node->getSubtreeBox(&childBox)) continue;
+			childBox.transform(node->getMatrix());
+			if(_subtreeEmpty) _subtreeBox = childBox;
+			else _subtreeBox.merge(childBox);
+			_subtreeEmpty = false;
 		}
+		_subtreeBoxVersion = _boundsVersion;
+	}
+	*box = _subtreeBox;
+	return !_subtreeEmpty;
+}
+
+//world box of me and all my descendants, merged from my own box and my children's - false if none has vertices
+bool MyNode::getTreeBox(BoundingBox *box) {
+	if(_treeBoxVersion != _boundsVersion) {
+		_treeEmpty = _worldVertices.empty();
+		_treeBox = _worldBox;
+		BoundingBox childBox;
+		for(Node *child = getFirstChild(); child; child = child->getNextSibling()) {
+			MyNode *node = dynamic_cast<MyNode*>(child);
+			if(!node || !node->getTreeBox(&childBox)) continue;
+			if(_treeEmpty) _treeBox = childBox;
+			else _treeBox.merge(childBox);
+			_treeEmpty = false;
+		}
+		_treeBoxVersion = _boundsVersion;
+	}
+	*box = _treeBox;
+	return !_treeEmpty;
+}
+
+//my world vertices or my place in the tree changed, so the cached bounds of me and all my ancestors are stale
+void MyNode::invalidateBounds() {
+	for(Node *n = this; n != NULL; n = n->getParent()) {
+		MyNode *node = dynamic_cast<MyNode*>(n);
+		if(node) node->_boundsVersion++;
 	}
-	return BoundingBox(min, max);
 }
 
 float MyNode::getMaxValue(const Vector3 &axis, bool modelSpace, const Vector3 &center) {
 	float max = -1e6, val;
-	//check children first
 	Vector3 base = center.isZero() ? getTranslationWorld() : center;
+	if(!modelSpace) {
+		//in world space the base only shifts the answer, so the subtree's support along the axis can be cached
+		if(!getSupport(axis, &val)) return max;
+		return fmax(val - base.dot(axis), max);
+	}
+	//check children first
 	for(Node *child = getFirstChild(); child; child = child->getNextSibling()) {
 		MyNode *node = dynamic_cast<MyNode*>(child);
 		if(node) {
@@ -851,13 +1088,84 @@ float MyNode::getMaxValue(const Vector3 &axis, bool modelSpace, const Vector3 &c
 	short i, n = this->nv();
 	Vector3 vec;
 	for(i = 0; i < n; i++) {
-		vec = (modelSpace ? _vertices[i] : _worldVertices[i]) - base;
+		vec = _vertices[i] - base;
 		val = vec.dot(axis);
 		if(val > max) max = val;
 	}
 	return max;
 }
 
+//nearest point where a ray in world space meets my surface - the ray is taken into model space, so this holds even if
+//my world vertices are behind my transform
+bool MyNode::rayTest(const Ray &ray, float *distance, Vector3 *point, Vector3 *normal) {
+	Matrix m;
+	if(!getWorldMatrix().invert(&m)) return false;
+	Vector3 origin = ray.getOrigin(), dir = ray.getDirection(), a, e1, e2, p, q, s, edge1, edge2;
+	m.transformPoint(&origin);
+	m.transformVector(&dir); //not normalized, so the ray parameter is still the world distance
+	bool hit = false;
+	float best = 0, det, u, v, t;
+	short nf = _faces.size(), nt, i, j;
+	for(i = 0; i < nf; i++) {
+		Face &face = _faces[i];
+		nt = face.nt();
+		for(j = 0; j < nt; j++) {
+			a = _vertices[face.triangle(j, 0)];
+			e1 = _vertices[face.triangle(j, 1)] - a;
+			e2 = _vertices[face.triangle(j, 2)] - a;
+			Vector3::cross(dir, e2, &p);
+			det = e1.dot(p);
+			if(fabs(det) < 1e-10f) continue;
+			s = origin - a;
+			u = s.dot(p) / det;
+			if(u < 0 || u > 1) continue;
+			Vector3::cross(s, e1, &q);
+			v = dir.dot(q) / det;
+			if(v < 0 || u + v > 1) continue;
+			t = e2.dot(q) / det;
+			if(t < 0 || (hit && t >= best)) continue;
+			best = t;
+			edge1 = e1;
+			edge2 = e2;
+			hit = true;
+		}
+	}
+	if(!hit) return false;
+	*distance = best;
+	if(point) *point = ray.getOrigin() + ray.getDirection() * best;
+	if(normal) {
+		//the hit triangle's winding gives its outward side, as for the physics shapes
+		getWorldMatrix().transformVector(&edge1);
+		getWorldMatrix().transformVector(&edge2);
+		Vector3::cross(edge1, edge2, normal);
+		normal->normalize();
+	}
+	return true;
+}
+
+//furthest that my and my descendants' world vertices reach along an axis - false if there are none
+bool MyNode::getSupport(const Vector3 &axis, float *support) {
+	if(_supportVersion != _boundsVersion || axis != _supportAxis) {
+		short i, n = _worldVertices.size();
+		float val;
+		_supportEmpty = n == 0;
+		for(i = 0; i < n; i++) {
+			val = _worldVertices[i].dot(axis);
+			if(i == 0 || val > _support) _support = val;
+		}
+		for(Node *child = getFirstChild(); child; child = child->getNextSibling()) {
+			MyNode *node = dynamic_cast<MyNode*>(child);
+			if(!node || !node->getSupport(axis, &val)) continue;
+			if(_supportEmpty || val > _support) _support = val;
+			_supportEmpty = false;
+		}
+		_supportAxis = axis;
+		_supportVersion = _boundsVersion;
+	}
+	*support = _support;
+	return !_supportEmpty;
+}
+
 Vector3 MyNode::getCentroid() {
 	short i, n = nv(), maxInd = 0;
 	float max = 0, len;
@@ -1090,6 +1398,25 @@ void MyNode::copyMesh(Meshy *mesh) {
 	_objType = src->_objType;
 }
 
+void MyNode::swapMesh(Meshy *mesh) {
+	MyNode *other = dynamic_cast<MyNode*>(mesh);
+	if(!other) return;
+	Meshy::swapMesh(mesh);
+	_hulls.swap(other->_hulls);
+	short i;
+	for(i = 0; i < _hulls.size(); i++) _hulls[i]->_node = this;
+	for(i = 0; i < other->_hulls.size(); i++) other->_hulls[i]->_node = other;
+	_objType.swap(other->_objType);
+}
+
+size_t MyNode::getMemorySize() {
+	size_t bytes = sizeof(MyNode) + Meshy::getMemorySize();
+	short i;
+	for(i = 0; i < _hulls.size(); i++) bytes += sizeof(ConvexHull) + _hulls[i]->getMemorySize();
+	for(i = 0; i < _constraints.size(); i++) bytes += sizeof(nodeConstraint);
+	return bytes;
+}
+
 void MyNode::clearMesh() {
 	Meshy::clearMesh();
 	_hulls.clear();
@@ -1473,11 +1800,12 @@ bool MyNode::loadData(const char *file, bool doPhysics, bool doTexture)
 }
 
 void MyNode::writeData(const char *file, bool modelSpace) {
-	std::string filename = resolveFilename(file);
-	std::unique_ptr<Stream> stream(FileSystem::open(filename.c_str(), FileSystem::WRITE));
+	//write to a temp file and swap it in whole, so a crash partway leaves the last good file in place
+	std::string filename = resolveFilename(file), tmpname = filename + ".tmp";
+	std::unique_ptr<Stream> stream(FileSystem::open(tmpname.c_str(), FileSystem::WRITE));
 	if (stream.get() == NULL)
 	{
-		GP_ERROR("Failed to open file '%s'.", filename.c_str());
+		GP_ERROR("Failed to open file '%s'.", tmpname.c_str());
 		return;
 	}
 	short i, j, k;
@@ -1597,6 +1925,7 @@ void MyNode::writeData(const char *file, bool modelSpace) {
 	line = os.str();
 	stream->write(line.c_str(), sizeof(char), line.length());
 	stream->close();
+	if(!FileSystem::renameFile(tmpname.c_str(), filename.c_str())) GP_WARN("Failed to replace file '%s'", filename.c_str());
 	for(i = 0; i < children.size(); i++) children[i]->writeData(file);
 }
 
@@ -1713,8 +2042,27 @@ void MyNode::stopAnimation() {
 }
 
 void MyNode::updateTransform() {
+	_transformDirty = false;
 	Meshy::updateTransform();
-	for(short i = 0; i < _hulls.size(); i++) _hulls[i]->updateTransform();
+	short i, n = _worldVertices.size();
+	Vector3 min, max, localMin, localMax;
+	for(i = 0; i < n; i++) {
+		const Vector3 &v = _worldVertices[i], &u = _vertices[i];
+		if(i == 0) {
+			min = max = v;
+			localMin = localMax = u;
+		}
+		min.set(fmin(min.x, v.x), fmin(min.y, v.y), fmin(min.z, v.z));
+		max.set(fmax(max.x, v.x), fmax(max.y, v.y), fmax(max.z, v.z));
+		localMin.set(fmin(localMin.x, u.x), fmin(localMin.y, u.y), fmin(localMin.z, u.z));
+		localMax.set(fmax(localMax.x, u.x), fmax(localMax.y, u.y), fmax(localMax.z, u.z));
+	}
+	_worldBox.set(min, max);
+	if(n > 0) _localBox.set(localMin, localMax);
+	else _localBox = BoundingBox::empty();
+	invalidateBounds();
+	app->nodeMoved(this);
+	for(i = 0; i < _hulls.size(); i++) _hulls[i]->updateTransform();
 	if(_visualMesh) _visualMesh->updateTransform();
 	for(Node *child = getFirstChild(); child; child = child->getNextSibling()) {
 		MyNode *node = dynamic_cast<MyNode*>(child);
@@ -1722,6 +2070,21 @@ void MyNode::updateTransform() {
 	}
 }
 
+//hierarchy changes come through here too - use them to tell the app its render queues are stale
+void MyNode::transformChanged() {
+	Node::transformChanged();
+	app->nodeMoved(this);
+	if(getParent() != _renderParent) {
+		MyNode *oldParent = dynamic_cast<MyNode*>(_renderParent);
+		if(oldParent) oldParent->invalidateBounds();
+		invalidateBounds();
+		_renderParent = getParent();
+		app->invalidateRenderQueues();
+		app->invalidateNodeIndex();
+		app->invalidateSceneTree();
+	}
+}
+
 void MyNode::updateEdges() {
 	Meshy::updateEdges();
 	for(short i = 0; i < _hulls.size(); i++) _hulls[i]->updateEdges();
@@ -1732,16 +2095,19 @@ void MyNode::setNormals() {
 	for(short i = 0; i < _hulls.size(); i++) _hulls[i]->setNormals();
 }
 
-void MyNode::updateModel(bool doPhysics, bool doCenter, bool doTexture) {
+void MyNode::updateModel(bool doPhysics, bool doCenter, bool doTexture, bool doIndex) {
 	if(nv() == 0) return;
 	if(_type.compare("root") != 0) {
-		//must detach from parent while setting transformation since physics object is off
-		Node *parent = getParent();
+		//if the node stays put, an existing rigid body can just take the new shape
+		PhysicsCollisionObject *obj = getCollisionObject();
+		bool inPlace = doPhysics && !doCenter && obj && obj->getType() == PhysicsCollisionObject::RIGID_BODY;
+		//otherwise must detach from parent while setting transformation since physics object is off
+		Node *parent = inPlace ? NULL : getParent();
 		if(parent != NULL) {
 			addRef();
 			parent->removeChild(this);
 		}
-		removePhysics(false);
+		if(!inPlace) removePhysics(false);
 
 		//update the mesh to contain the new coordinates
 		float radius = 0, f1;
@@ -1778,89 +2144,112 @@ void MyNode::updateModel(bool doPhysics, bool doCenter, bool doTexture) {
 		unsigned short vertexSize = doTexture ? 8 : 6;
 		unsigned int ind, triangleCount = 0;
 
-		//then create the new model
-		if(_visualMesh) _visualMesh->updateAll();
-		Meshy *mesh = _visualMesh ? _visualMesh : this;
-		nv = mesh->nv();
-		nf = mesh->nf();
-		std::vector<float> vertices;
-		if(_chain) {
-			n = _loop ? nv : nv-1;
-			vertices.resize(2 * n * vertexSize);
-			for(i = 0; i < n; i++) {
-				for(j = 0; j < 2; j++) {
-					for(k = 0; k < 3; k++) vertices[v++] = gv(mesh->_vertices[(i+j)%nv], k);
-					vertices[v++] = _color.x;
-					vertices[v++] = _color.y;
-					vertices[v++] = _color.z;
-					if(doTexture) for(k = 0; k < 2; k++) vertices[v++] = 0;
+		//headless runs only need the vertices, hulls and constraints - no GL model
+		if(!app->_headless) {
+			//then create the new model
+			if(_visualMesh) _visualMesh->updateAll();
+			Meshy *mesh = _visualMesh ? _visualMesh : this;
+			nv = mesh->nv();
+			nf = mesh->nf();
+			std::vector<float> vertices;
+			std::vector<unsigned int> indices;
+			if(_chain) {
+				n = _loop ? nv : nv-1;
+				vertices.resize(2 * n * vertexSize);
+				for(i = 0; i < n; i++) {
+					for(j = 0; j < 2; j++) {
+						for(k = 0; k < 3; k++) vertices[v++] = gv(mesh->_vertices[(i+j)%nv], k);
+						vertices[v++] = _color.x;
+						vertices[v++] = _color.y;
+						vertices[v++] = _color.z;
+						if(doTexture) for(k = 0; k < 2; k++) vertices[v++] = 0;
+					}
 				}
-			}
-		} else {
-			n = 0;
-			for(i = 0; i < nf; i++) {
-				n += mesh->_faces[i].nt() * 3;
-				if(mesh->_faces[i].nt() == 0) GP_WARN("face %d has no triangles", i);
-			}
-			vertices.resize(n * vertexSize);
-			std::map<unsigned short, float> texU, texV;
-			bool bufferAligned = true;
-			for(i = 0; i < nf; i++) {
-				n = mesh->_faces[i].size();
-				if(doTexture) { //determine the texcoord for each vertex in the face
-					texU.clear();
-					texV.clear();
+			} else {
+				//vertices are shared within each face so normals stay faceted, and triangles are indexed
+				n = 0;
+				for(i = 0; i < nf; i++) {
+					n += mesh->_faces[i].nt() * 3;
+					if(mesh->_faces[i].nt() == 0) GP_WARN("face %d has no triangles", i);
+				}
+				indices.resize(n);
+				vertices.reserve(n * vertexSize);
+				std::map<unsigned short, float> texU, texV;
+				std::map<unsigned short, unsigned int> faceVertex; //mesh vertex => model vertex for the current face
+				std::map<unsigned short, unsigned int>::iterator it;
+				unsigned int numVertices = 0;
+				for(i = 0; i < nf; i++) {
+					n = mesh->_faces[i].size();
+					if(doTexture) { //determine the texcoord for each vertex in the face
+						texU.clear();
+						texV.clear();
+						for(j = 0; j < n; j++) {
+							ind = mesh->_faces[i][j];
+							switch(n) {
+								case 3:
+									switch(j) {
+										case 0: texU[ind] = 0; texV[ind] = 0; break;
+										case 1: texU[ind] = 1; texV[ind] = 0; break;
+										case 2: texU[ind] = 0; texV[ind] = 1; break;
+										default: break;
+									}
+									break;
+								case 4:
+									switch(j) {
+										case 0: texU[ind] = 0; texV[ind] = 0; break;
+										case 1: texU[ind] = 1; texV[ind] = 0; break;
+										case 2: texU[ind] = 1; texV[ind] = 1; break;
+										case 3: texU[ind] = 0; texV[ind] = 1; break;
+									}
+									break;
+								default:
+									break;
+							}
+						}
+					}
+					faceVertex.clear();
+					n = mesh->_faces[i].nt();
+					normal = mesh->_faces[i].getNormal(true);
 					for(j = 0; j < n; j++) {
-						ind = mesh->_faces[i][j];
-						switch(n) {
-							case 3:
-								switch(j) {
-									case 0: texU[ind] = 0; texV[ind] = 0; break;
-									case 1: texU[ind] = 1; texV[ind] = 0; break;
-									case 2: texU[ind] = 0; texV[ind] = 1; break;
-									default: break;
-								}
-								break;
-							case 4:
-								switch(j) {
-									case 0: texU[ind] = 0; texV[ind] = 0; break;
-									case 1: texU[ind] = 1; texV[ind] = 0; break;
-									case 2: texU[ind] = 1; texV[ind] = 1; break;
-									case 3: texU[ind] = 0; texV[ind] = 1; break;
+						for(k = 0; k < 3; k++) {
+							ind = mesh->_faces[i].triangle(j, k);
+							it = faceVertex.find(ind);
+							if(it == faceVertex.end()) {
+								vec = mesh->_vertices[ind];
+								for(m = 0; m < 3; m++) vertices.push_back(gv(vec, m));
+								for(m = 0; m < 3; m++) vertices.push_back(gv(normal, m));
+								if(doTexture) {
+									vertices.push_back(texU.find(ind) != texU.end() ? texU[ind] : 0);
+									vertices.push_back(texV.find(ind) != texV.end() ? texV[ind] : 0);
 								}
-								break;
-							default:
-								break;
+								it = faceVertex.insert(std::pair<unsigned short, unsigned int>(ind, numVertices++)).first;
+							}
+							indices[v++] = it->second;
 						}
+						triangleCount++;
 					}
 				}
-				n = mesh->_faces[i].nt();
-				normal = mesh->_faces[i].getNormal(true);
-				for(j = 0; j < n; j++) {
-					bufferAligned = v == triangleCount * (3 * vertexSize);
-					if(_type.compare("hair_curler") == 0 && !bufferAligned) {
-						GP_ERROR("starting triangle %d (face %d triangle %d) at %d + %d", triangleCount, i, j, v/(3*vertexSize), v%(3*vertexSize));
-						bufferAligned = false;
-					}
-					for(k = 0; k < 3; k++) {
-						ind = mesh->_faces[i].triangle(j, k);
-						vec = mesh->_vertices[ind];
-						for(m = 0; m < 3; m++) vertices[v++] = gv(vec, m);
-						for(m = 0; m < 3; m++) vertices[v++] = gv(normal, m);
-						if(doTexture) {
-							vertices[v++] = texU.find(ind) != texU.end() ? texU[ind] : 0;
-							vertices[v++] = texV.find(ind) != texV.end() ? texV[ind] : 0;
-						}
+				if(doIndex) optimizeTriangleOrder(indices, numVertices);
+				//16-bit indices can't address a huge mesh, so expand it back out to one vertex per corner
+				if(!doIndex || numVertices > 65535) {
+					if(doIndex) GP_WARN("mesh %s has %d vertices - not indexing", _id.c_str(), numVertices);
+					std::vector<float> expanded(indices.size() * vertexSize);
+					for(i = 0; i < indices.size(); i++) {
+						for(j = 0; j < vertexSize; j++) expanded[i * vertexSize + j] = vertices[indices[i] * vertexSize + j];
 					}
-					triangleCount++;
+					vertices.swap(expanded);
+					indices.clear();
 				}
 			}
+			std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+			app->createModel(vertices, _chain, _id.c_str(), this, doTexture, shortIndices.empty() ? NULL : &shortIndices);
+			_lightNode = NULL;
+			_drawColor.set(-1.0f, -1.0f, -1.0f, 1.0f); //new material has its default color until setColor
+			Mesh *me = getModel()->getMesh();
+			me->setBoundingBox(box);
+			me->setBoundingSphere(sphere);
+			if(_color.x >= 0) setColor(_color.x, _color.y, _color.z, _color.w); //updates the model's color
 		}
-		app->createModel(vertices, _chain, _id.c_str(), this, doTexture);
-		Mesh *me = getModel()->getMesh();
-		me->setBoundingBox(box);
-		me->setBoundingSphere(sphere);
-		if(_color.x >= 0) setColor(_color.x, _color.y, _color.z, _color.w); //updates the model's color
 
 		//update convex hulls and constraints to reflect shift in node origin
 		if(doCenter) {
@@ -1879,7 +2268,8 @@ void MyNode::updateModel(bool doPhysics, bool doCenter, bool doTexture) {
 				}
 			}
 		}
-		if(doPhysics) addPhysics(false);
+		if(inPlace) updateCollisionShape(false);
+		else if(doPhysics) addPhysics(false);
 		if(parent != NULL) {
 			parent->addChild(this);
 			release();
@@ -2197,17 +2587,27 @@ MaterialParameter* MyNode::getMaterialParameter(const char *name) {
 
 void MyNode::setColor(float r, float g, float b, float a, bool save, bool recur) {
 	if(save) _color.set(r, g, b, a);
+	if(_drawColor.x < 0) app->invalidateRenderQueues(); //may now be drawn as an instance
+	_drawColor.set(r, g, b, a);
 	MaterialParameter *ambient = getMaterialParameter("u_ambientColor");
 	if(ambient) ambient->setValue(Vector3(r, g, b));
 	MaterialParameter *alpha = getMaterialParameter("u_modulateAlpha");
 	if(alpha) alpha->setValue(a);
-	if(a < 1) setTag("transparent");
+	if(a < 1 && !hasTag("transparent")) {
+		setTag("transparent");
+		app->invalidateRenderQueues();
+	}
 }
 
 void MyNode::setTexture(const char *imagePath) {
 	Model *model = getModel();
 	if(!model) return;
-	model->setMaterial("res/common/models.material#textured");
+	Material *material = app->createMaterial("textured");
+	model->setMaterial(material);
+	SAFE_RELEASE(material);
+	_lightNode = NULL;
+	_drawColor.set(-1.0f, -1.0f, -1.0f, 1.0f); //texture is per-node state, so never draw as an instance
+	app->invalidateRenderQueues();
 	MaterialParameter *param = getMaterialParameter("u_diffuseTexture");
 	if(!param) return;
 	Texture::Sampler *sampler = param->getSampler();
@@ -2338,18 +2738,15 @@ char* MyNode::concat(int n, ...)
 /*********** TRANSFORM ***********/
 
 void MyNode::set(const Matrix& trans) {
-	PhysicsCollisionObject *obj = getCollisionObject();
-	bool doPhysics = obj != NULL && obj->isEnabled();
-	if(doPhysics) enablePhysics(false, false);
-
 	Vector3 translation, scale;
 	Quaternion rotation;
 	trans.decompose(&scale, &rotation, &translation);
 	setScale(scale);
 	setRotation(rotation);
 	setTranslation(translation);
-	
-	if(doPhysics) enablePhysics(true, false);
+	//my body is pushed with the rest of the frame's moves rather than leaving and rejoining the physics world now
+	PhysicsCollisionObject *obj = getCollisionObject();
+	app->queueTransform(this, obj != NULL && obj->isEnabled());
 }
 
 void MyNode::set(Node *other) {
@@ -2377,6 +2774,7 @@ void MyNode::myTranslate(const Vector3& delta, short depth) {
 			translate(delta);
 		}
 	}
+	if(depth == 0) app->queueTransform(this);
 }
 
 void MyNode::setMyTranslation(const Vector3& translation) {
@@ -2406,6 +2804,7 @@ void MyNode::myRotate(const Quaternion& delta, Vector3 *center, short depth) {
 		setRotation(delta * getRotation());
 		if(!trans.isZero()) myTranslate(trans);
 	}
+	if(depth == 0) app->queueTransform(this);
 }
 
 void MyNode::setMyRotation(const Quaternion& rotation, Vector3 *center) {
@@ -2480,7 +2879,6 @@ Quaternion MyNode::getAttachRotation(const Vector3 &norm) {
 }
 
 void MyNode::attachTo(MyNode *parent, const Vector3 &point, const Vector3 &norm) {
-	updateTransform();
 	BoundingBox box = getBoundingBox(true, false);
 	Quaternion rot = getAttachRotation(norm);
 	setAnchorRotation(rot);
@@ -2511,9 +2909,16 @@ void MyNode::updateMaterial(bool recur) {
 	if(light == NULL) return;
 	Model *model = getModel();
 	if(model == NULL) return;
+	//the light parameters stay bound to the material, so only bind them when the material or light changes
+	if(lightNode == _lightNode) return;
+	_lightNode = lightNode;
 	unsigned int partCount = model->getMeshPartCount(), n = partCount > 0 ? partCount : 1, i;
+	Material *material, *lastMaterial = NULL;
 	for(i = 0; i < n; i++) {
-		Technique *technique = model->getMaterial(partCount > 0 ? i : -1)->getTechnique();
+		material = model->getMaterial(partCount > 0 ? i : -1);
+		if(material == NULL || material == lastMaterial) continue; //parts usually share one material
+		lastMaterial = material;
+		Technique *technique = material->getTechnique();
 		if(technique == NULL) continue;
 		MaterialParameter *color = technique->getParameter("u_directionalLightColor[0]"),
 			*direction = technique->getParameter("u_directionalLightDirection[0]");
@@ -2578,6 +2983,54 @@ void MyNode::placeRest() {
 	}
 }
     
+void MyNode::saveSnapshot(PhysicsSnapshot &snapshot) {
+	PhysicsSnapshot::BodyState state;
+	state.node = this;
+	getMatrix().decompose(&state.scale, &state.rotation, &state.translation);
+	PhysicsRigidBody *body = dynamic_cast<PhysicsRigidBody*>(getCollisionObject());
+	if(body) {
+		state.linearVelocity = body->getLinearVelocity();
+		state.angularVelocity = body->getAngularVelocity();
+		state.activation = body->getActivation();
+	} else state.activation = -1;
+	snapshot.bodies.push_back(state);
+	for(short i = 0; i < _constraints.size(); i++) {
+		int id = _constraints[i]->id;
+		if(id < 0 || app->_constraints.find(id) == app->_constraints.end()) continue;
+		snapshot.constraints.push_back(std::make_pair(id, app->_constraints[id]->isEnabled()));
+	}
+	for(MyNode *node = dynamic_cast<MyNode*>(getFirstChild()); node; node = dynamic_cast<MyNode*>(node->getNextSibling())) {
+		node->saveSnapshot(snapshot);
+	}
+}
+
+//unlike set/placeRest, bodies stay in the physics world - they are just moved
+void MyNode::restoreSnapshot(const PhysicsSnapshot &snapshot) {
+	size_t i, n = snapshot.bodies.size();
+	for(i = 0; i < n; i++) {
+		const PhysicsSnapshot::BodyState &state = snapshot.bodies[i];
+		state.node->setScale(state.scale);
+		state.node->setRotation(state.rotation);
+		state.node->setTranslation(state.translation);
+	}
+	//all nodes must be in place before any body reads its world transform
+	for(i = 0; i < n; i++) {
+		const PhysicsSnapshot::BodyState &state = snapshot.bodies[i];
+		if(state.activation < 0) continue;
+		PhysicsRigidBody *body = dynamic_cast<PhysicsRigidBody*>(state.node->getCollisionObject());
+		if(!body) continue;
+		body->syncTransform();
+		body->setLinearVelocity(state.linearVelocity);
+		body->setAngularVelocity(state.angularVelocity);
+		body->forceActivation(state.activation);
+	}
+	T4TApp *app = (T4TApp*) Game::getInstance();
+	for(i = 0; i < snapshot.constraints.size(); i++) {
+		std::unordered_map<int, ConstraintPtr>::iterator it = app->_constraints.find(snapshot.constraints[i].first);
+		if(it != app->_constraints.end() && it->second) it->second->setEnabled(snapshot.constraints[i].second);
+	}
+}
+
 void MyNode::setTheta(float theta) {
     _theta = theta;
     setUserRotation();
@@ -2607,38 +3060,68 @@ void MyNode::updateRotation() {
 
 /*********** PHYSICS ************/
 
-void MyNode::addCollisionObject() {
-	if(_type.compare("root") == 0) return;
-	PhysicsRigidBody::Parameters params;
-	params.mass = _staticObj ? 0.0f : _mass;
+//for a mesh, the definition points at this node's vertices and the given hulls until the shape is built
+PhysicsCollisionShape::Definition MyNode::getCollisionShape(std::vector<std::vector<Vector3> > &hulls) {
 	if(_objType.compare("mesh") == 0) {
-		Mesh *mesh = getModel()->getMesh();
+		Mesh *mesh = getModel() ? getModel()->getMesh() : app->_physicsMesh;
+		hulls.resize(_hulls.size());
+		for(short i = 0; i < _hulls.size(); i++) hulls[i] = _hulls[i]->_vertices;
 		mesh->vertices = &_vertices;
-		mesh->hulls = new std::vector<std::vector<Vector3> >();
-		for(short i = 0; i < _hulls.size(); i++) {
-			mesh->hulls->push_back(_hulls[i]->_vertices);
-		}
-		setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::mesh(mesh), &params);
+		mesh->hulls = &hulls;
+		return PhysicsCollisionShape::mesh(mesh);
 	} else if(_objType.compare("box") == 0) {
-		PhysicsCollisionShape::Definition box;
-		if(_boundingBox.isEmpty()) {
-			box = PhysicsCollisionShape::box();
-		} else {
-			box = PhysicsCollisionShape::box(_boundingBox.max - _boundingBox.min, _boundingBox.getCenter(), true);
-		}
-		setCollisionObject(PhysicsCollisionObject::RIGID_BODY, box, &params);
+		if(_boundingBox.isEmpty()) return PhysicsCollisionShape::box();
+		return PhysicsCollisionShape::box(_boundingBox.max - _boundingBox.min, _boundingBox.getCenter(), true);
 	} else if(_objType.compare("sphere") == 0) {
-		setCollisionObject(PhysicsCollisionObject::RIGID_BODY,
-		  _radius > 0 ? PhysicsCollisionShape::sphere(_radius) : PhysicsCollisionShape::sphere(), &params);
+		return _radius > 0 ? PhysicsCollisionShape::sphere(_radius) : PhysicsCollisionShape::sphere();
 	} else if(_objType.compare("capsule") == 0) {
-		setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::capsule(), &params);
-	} else if(_objType.compare("ghost") == 0) {
-		setCollisionObject(PhysicsCollisionObject::GHOST_OBJECT, PhysicsCollisionShape::sphere(), &params);
+		return PhysicsCollisionShape::capsule();
 	}
+	return PhysicsCollisionShape::sphere();
 }
 
+void MyNode::clearCollisionShape() {
+	if(_objType.compare("mesh") != 0) return;
+	Mesh *mesh = getModel() ? getModel()->getMesh() : app->_physicsMesh;
+	mesh->vertices = NULL;
+	mesh->hulls = NULL;
+}
+
+void MyNode::addCollisionObject() {
+	if(_type.compare("root") == 0) return;
+	if(_objType.compare("mesh") != 0 && _objType.compare("box") != 0 && _objType.compare("sphere") != 0
+	  && _objType.compare("capsule") != 0 && _objType.compare("ghost") != 0) return;
+	PhysicsRigidBody::Parameters params;
+	params.mass = _staticObj ? 0.0f : _mass;
+	//hulls are only read while the shape is built - identical hulls reuse the physics controller's cached shape
+	std::vector<std::vector<Vector3> > hulls;
+	PhysicsCollisionShape::Definition shape = getCollisionShape(hulls);
+	setCollisionObject(_objType.compare("ghost") == 0 ? PhysicsCollisionObject::GHOST_OBJECT : PhysicsCollisionObject::RIGID_BODY,
+	  shape, &params);
+	clearCollisionShape();
+}
+
+//rebuild the collision shape at the current scale, keeping the body and its constraints
+void MyNode::updateCollisionShape(bool recur) {
+	PhysicsCollisionObject *obj = getCollisionObject();
+	if(obj && obj->getType() == PhysicsCollisionObject::RIGID_BODY) {
+		std::vector<std::vector<Vector3> > hulls;
+		PhysicsCollisionShape::Definition shape = getCollisionShape(hulls);
+		((PhysicsRigidBody*)obj)->updateShape(shape);
+		clearCollisionShape();
+	}
+	if(recur) {
+		for(MyNode *node = dynamic_cast<MyNode*>(getFirstChild()); node; node = dynamic_cast<MyNode*>(node->getNextSibling())) {
+			node->updateCollisionShape();
+		}
+	}
+}
+
+//the whole subtree goes into the physics world at once, when the outermost batch ends
 void MyNode::addPhysics(bool recur) {
 	if(_objType.compare("none") == 0) return;
+	PhysicsController *controller = app->getPhysicsController();
+	controller->beginBatch();
 	if(getCollisionObject() == NULL) {
 		addCollisionObject();
 		app->addConstraints(this);
@@ -2648,6 +3131,7 @@ void MyNode::addPhysics(bool recur) {
 			node->addPhysics();
 		}
 	}
+	controller->endBatch();
 }
 
 void MyNode::removePhysics(bool recur) {
@@ -2774,29 +3258,15 @@ PhysicsConstraint* MyNode::getConstraint(MyNode *other) {
 
 nodeConstraint* MyNode::getNodeConstraint(MyNode *other) {
 	for(short i = 0; i < _constraints.size(); i++) {
-		if(_constraints[i]->other.compare(other->getId()) == 0) return _constraints[i].get();
+		if(_constraints[i]->node == other || _constraints[i]->other.compare(other->getId()) == 0) return _constraints[i].get();
 	}
 	return NULL;
 }
 
-MyNode* MyNode::getConstraintNode(nodeConstraint *constraint) {
-	Node *node = app->_scene->findNode(constraint->other.c_str());
-	if(node == NULL) return NULL;
-	return dynamic_cast<MyNode*>(node);
-}
-
-bool MyNode::isBroken() { //true if any constraint among me or my child nodes is disabled
-	std::vector<MyNode*> nodes = getAllNodes();
-	short i, j, n = nodes.size();
-	for(i = 0; i < n-1; i++) {
-		for(j = i+1; j < n; j++) {
-			nodeConstraint *nc = nodes[i]->getNodeConstraint(nodes[j]);
-			if(nc == NULL || nc->id < 0 || app->_constraints.find(nc->id) == app->_constraints.end()) continue;
-			PhysicsConstraint *constraint = app->_constraints[nc->id].get();
-			if(constraint && !constraint->isEnabled()) return true;
-		}
-	}
-	return false;
+MyNode* MyNode::getConstraintNode(nodeConstraint *constraint, Scene *scene) {
+	if(!scene) scene = app->_scene;
+	if(constraint->node && constraint->node->getScene() == scene) return constraint->node;
+	return app->lookupNode(constraint->other, scene);
 }
 
 Vector3 MyNode::getAnchorPoint() {
@@ -25,7 +25,9 @@ public:
 	bool _wireframe, //drawing option for debugging
 		_chain, _loop; //whether node is treated as vertex chain or triangle mesh
 	float _lineWidth; //OpenGL line width if wireframe
-	Vector4 _color;
+	Vector4 _color, _drawColor; //saved color and the one currently applied to my material
+	Node *_lightNode; //light my current material's light parameters are bound to
+	Node *_renderParent; //parent when the app's render queues last saw me
 	
 	//my vertices in the coord frame of the camera
 	std::vector<Vector3> _cameraVertices, _cameraNormals;
@@ -48,6 +50,17 @@ public:
 	std::vector<std::unique_ptr<ConvexHull> > _hulls;
 	std::vector<std::unique_ptr<nodeConstraint> > _constraints;
 	BoundingBox _boundingBox;
+	//cached bounds - my own world box is redone with my world vertices, and anything that changes those or my place
+	//in the tree bumps the bounds version of me and my ancestors, so the caches built from my subtree go stale
+	BoundingBox _worldBox, _treeBox, _subtreeBox;
+	BoundingBox _localBox; //my own vertices in model space, for the app's scene tree
+	int _treeLeaf; //my leaf in the app's scene tree, if it still holds me
+	//moved since the last frame - my world data and/or body wait for the app's next flushTransforms
+	bool _moveQueued, _transformDirty, _bodyDirty;
+	Vector3 _supportAxis; //last axis my subtree's support was found along
+	float _support;
+	bool _treeEmpty, _subtreeEmpty, _supportEmpty;
+	unsigned int _boundsVersion, _treeBoxVersion, _subtreeBoxVersion, _supportVersion;
 	//for a compound object, store a rest position for each node so we have a rest configuration for the object
 	Matrix _restPosition;
 	//when moving a node, need to know if it should move independently or relative to the node it is constrained to
@@ -75,8 +88,10 @@ public:
 	AnimationClip *_currentClip;
 
 	MyNode(const char *id);
+	~MyNode();
 	static MyNode* create(const char *id = NULL);
 	void init();
+	void setId(const char *id);
 	static MyNode* cloneNode(Node *node);
 	
 	std::string resolveFilename(const char *filename = NULL);
@@ -89,9 +104,10 @@ public:
 	void playAnimation(const char *id, bool repeat = false, float speed = 1.0f);
 	void stopAnimation();
 	void updateTransform();
+	void transformChanged();
 	void updateEdges();
 	void setNormals();
-	void updateModel(bool doPhysics = true, bool doCenter = true, bool doTexture = false);
+	void updateModel(bool doPhysics = true, bool doCenter = true, bool doTexture = false, bool doIndex = true);
 	void updateCamera(bool doPatches = true);
 	void mergeVertices(float threshold);
 	void calculateHulls();
@@ -110,7 +126,13 @@ public:
 	Vector3 getScaleVertex(short v);
 	Vector3 getScaleNormal(short f);
 	BoundingBox getBoundingBox(bool modelSpace = false, bool recur = true);
+	BoundingBox getMeshBox();
+	bool getTreeBox(BoundingBox *box);
+	bool getSubtreeBox(BoundingBox *box);
 	float getMaxValue(const Vector3 &axis, bool modelSpace = false, const Vector3 &center = Vector3::zero());
+	bool getSupport(const Vector3 &axis, float *support);
+	bool rayTest(const Ray &ray, float *distance, Vector3 *point = NULL, Vector3 *normal = NULL);
+	void invalidateBounds();
 	Vector3 getCentroid();
 	void set(const Matrix& trans);
 	void set(Node *other);
@@ -135,6 +157,8 @@ public:
 	void baseScale(const Vector3& delta);
 	void setRest();
 	void placeRest();
+	void saveSnapshot(PhysicsSnapshot &snapshot);
+	static void restoreSnapshot(const PhysicsSnapshot &snapshot);
     void setAnchorRotation(Quaternion rot);
     void setTheta(float theta);
     void setPhi(float phi);
@@ -157,7 +181,9 @@ public:
 	  std::vector<std::vector<unsigned short> >& triangles, Vector3 normal);
 	void setWireframe(bool wireframe);
 	void copyMesh(Meshy *mesh);
+	void swapMesh(Meshy *mesh);
 	void clearMesh();
+	size_t getMemorySize();
 	std::vector<MyNode*> getAllNodes();
 	void addComponentInstance(std::string id, const std::vector<unsigned short> &instance);
 	void printTree(short level = 0);
@@ -169,7 +195,10 @@ public:
 	void setOneHull();
 	bool isStatic();
 	void setStatic(bool stat);
+	PhysicsCollisionShape::Definition getCollisionShape(std::vector<std::vector<Vector3> > &hulls);
+	void clearCollisionShape();
 	void addCollisionObject();
+	void updateCollisionShape(bool recur = true);
 	void addPhysics(bool recur = true);
 	void removePhysics(bool recur = true);
 	void enablePhysics(bool enable = true, bool recur = true);
@@ -181,8 +210,7 @@ public:
 	void removeMe();
 	PhysicsConstraint* getConstraint(MyNode *other);
 	nodeConstraint* getNodeConstraint(MyNode *other);
-	MyNode *getConstraintNode(nodeConstraint *constraint);
-	bool isBroken();
+	MyNode *getConstraintNode(nodeConstraint *constraint, Scene *scene = NULL);
 	//get the world space joint attributes
 	Vector3 getAnchorPoint();
 	Vector3 getJointAxis();
@@ -105,8 +105,13 @@ void PositionMode::controlEvent(Control *control, Control::Listener::EventType e
 	} else if(control == _staticCheckbox) {
 		if(_selectedNode != NULL) {
 			_selectedNode->setStatic(_staticCheckbox->isChecked());
-			_selectedNode->removePhysics();
-			_selectedNode->addPhysics();
+			PhysicsCollisionObject *obj = _selectedNode->getCollisionObject();
+			if(obj && obj->getType() == PhysicsCollisionObject::RIGID_BODY) {
+				((PhysicsRigidBody*)obj)->setMass(_selectedNode->isStatic() ? 0.0f : _selectedNode->_mass);
+			} else {
+				_selectedNode->removePhysics();
+				_selectedNode->addPhysics();
+			}
 		}
 	} else if(strcmp(id, "delete") == 0 && _selectedNode != NULL) {
 		app->doConfirm(MyNode::concat(2, "Are you sure you want to delete node ", _selectedNode->getId()), &T4TApp::confirmDelete);
@@ -40,6 +40,8 @@ Project::Project(const char* id, const char *name) : Mode::Mode(id, name) {
 	_currentElement = 0;
 	_instructionsPage = 0;
 	_moveMode = 0;
+	_launchButton = NULL;
+	_activateButton = NULL;
 	_launching = false;
 	_saveFlag = false;
 	_started = false;
@@ -47,7 +49,9 @@ Project::Project(const char* id, const char *name) : Mode::Mode(id, name) {
 
 	_subModes.push_back("build");
 	_subModes.push_back("test");
-	
+
+	//the project menu button and instructions are only for the UI
+	if(app->_headless) return;
 	std::ostringstream os;
 	os << "res/png/" << _id << ".png";
 	const char *title = _name.c_str();
@@ -236,7 +240,8 @@ void Project::controlEvent(Control *control, Control::Listener::EventType evt) {
 	} else if(control == _launchButton) {
 		launch();
     } else if(control == _buttons["reset"]) {
-        setSubMode(1);
+        if(_launchSnapshot.empty()) setSubMode(1);
+        else relaunch();
 	} else if(control == _activateButton) {
 		activate();
 	} else if(strcmp(id, "save") == 0) {
@@ -447,17 +452,20 @@ void Project::finish() {
 Project::Element* Project::addElement(Element *element) {
     element->_index = _elements.size();
 	_elements.push_back(std::shared_ptr<Element>(element));
+	_numElements = _elements.size();
 	return element;
 }
 
 void Project::addPhysics() {
 	short i, n = _elements.size();
+	app->getPhysicsController()->beginBatch();
 	for(i = 0; i < n; i++) {
 		short numNodes = _elements[i]->_nodes.size(), j;
 		for(j = 0; j < numNodes; j++) {
 			_elements[i]->addPhysics(j);
 		}
 	}
+	app->getPhysicsController()->endBatch();
 }
 
 void Project::setActive(bool active) {
@@ -468,10 +476,12 @@ void Project::setActive(bool active) {
 		_scene->addNode(_rootNode);
 		_rootNode->updateMaterial(true);
 		app->_ground->setVisible(false);
-		app->_componentMenu->setFocus();
+		if(!app->_headless) app->_componentMenu->setFocus();
 		app->filterItemMenu();
 		app->getPhysicsController()->setGravity(Vector3::zero());
 		app->getPhysicsController()->addStatusListener(this);
+		app->getPhysicsController()->addTickListener(this);
+		app->getPhysicsController()->addConstraintListener(this);
 		setInSequence(true);
         _choosingOther = false;
 		//determine the next element needing to be added
@@ -483,6 +493,7 @@ void Project::setActive(bool active) {
             setCurrentElement(el ? el->_index : _numElements);
 		}
 	} else {
+		_launchSnapshot.clear();
 		removePayload();
 		if(_buildAnchor.get() != nullptr) _buildAnchor->setEnabled(false);
 		if(_subMode == 0) _rootNode->setRest();
@@ -490,6 +501,8 @@ void Project::setActive(bool active) {
 		app->filterItemMenu();
 		app->getPhysicsController()->setGravity(app->_gravity);
 		app->getPhysicsController()->removeStatusListener(this);
+		app->getPhysicsController()->removeTickListener(this);
+		app->getPhysicsController()->removeConstraintListener(this);
 	}
 }
 
@@ -508,6 +521,7 @@ bool Project::setSubMode(short mode) {
 		}
 	}
 	_complete = true;
+	_launchSnapshot.clear(); //the model is being rebuilt or re-placed
 	bool building = _subMode == 0, changed = Mode::setSubMode(mode);
 	if(building) {
 		if(changed) {
@@ -540,7 +554,7 @@ bool Project::setSubMode(short mode) {
 		}
 	}
     setButtons();
-	_launchButton->setEnabled(_subMode == 1);
+	if(_launchButton) _launchButton->setEnabled(_subMode == 1);
 	_launching = false;
 	_launchComplete = false;
 	_broken = false;
@@ -553,6 +567,7 @@ void Project::setCurrentElement(short n) {
 }
 
 void Project::showInstructions() {
+	if(app->_headless) return;
 	app->_componentContainer->setVisible(false);
 	std::string title = _name + " - Instructions";
 	app->_componentWrapper->setScroll(Container::SCROLL_NONE);
@@ -581,6 +596,7 @@ void Project::navigateInstructions(bool forward) {
 }
     
 void Project::setButtons() {
+    if(app->_headless) return;
     hideButtons();
     switch(_subMode) {
         case 0: {
@@ -671,10 +687,22 @@ void Project::promptItem() {
 void Project::launch() {
 	_launching = true;
 	_launchSteps = 0;
-	_launchButton->setEnabled(false);
+	if(_launchButton) _launchButton->setEnabled(false);
 	app->message(NULL);
 }
 
+//put the model back as it was when the last launch started and run it again, without rebuilding any physics
+void Project::relaunch() {
+	MyNode::restoreSnapshot(_launchSnapshot);
+	_launching = true;
+	_launchSteps = 0;
+	_launchComplete = false;
+	_broken = false;
+	if(_launchButton) _launchButton->setEnabled(false);
+	app->message(NULL);
+	setButtons();
+}
+
 void Project::activate() {
 	_rootNode->setActivation(ACTIVE_TAG);
 }
@@ -702,19 +730,32 @@ void Project::launchComplete() {
 	}
 }
 
+//launch logic that must keep pace with the simulation rather than the frame rate
+void Project::physicsTick(float timeStep) {
+	if(!_launching) return;
+	//the first step sees the launch fully set up - keep it for retries
+	if(_launchSteps == 0 && _launchSnapshot.empty()) {
+		_rootNode->saveSnapshot(_launchSnapshot);
+		if(_payload) _payload->saveSnapshot(_launchSnapshot);
+	}
+	_launchSteps++;
+	//after launching, switch back to normal activation
+	if(_launchSteps == 100) {
+		_rootNode->setActivation(ACTIVE_TAG, true);
+	}
+}
+
 void Project::update() {
 	Mode::update();
-	if(_launching) {
-		_launchSteps++;
-		//after launching, switch back to normal activation
-		if(_launchSteps == 100) {
-			_rootNode->setActivation(ACTIVE_TAG, true);
-		}
-		//see if any piece has broken off - if so, the project failed
-		if(_rootNode->isBroken()) {
-			_broken = true;
-			app->message("Oh no! Something broke! Click 'Build' to fix your model.");
-		}
+}
+
+//if any piece of the model breaks off during launch, the project failed
+void Project::constraintBroken(PhysicsConstraint *constraint) {
+	if(!_launching || _broken) return;
+	Node *a = constraint->_a ? constraint->_a->getNode() : NULL, *b = constraint->_b ? constraint->_b->getNode() : NULL;
+	if((a && a->getRootNode() == _rootNode) || (b && b->getRootNode() == _rootNode)) {
+		_broken = true;
+		app->message("Oh no! Something broke! Click 'Build' to fix your model.");
 	}
 }
 
@@ -728,22 +769,30 @@ void Project::sync() {
 		app->message(os.str().c_str());
 	} else {
 		std::string dir = "http://www.t4t.org/nasa-app/upload/" + app->_userName + "/";
-		if(!_rootNode->loadData(dir.c_str(), false)) return;
-		_rootNode->setRest();
-		_rootNode->updateMaterial(true);
-		short n = _elements.size(), i;
-		for(i = 0; i < n; i++) {
-			Element *el = _elements[i].get();
-			short m = el->_nodes.size(), j;
-			for(j = 0; j < m; j++) el->addPhysics((j+1)%m); //"other" is first in list but should be done last
-		}
-		if(app->getActiveMode() != this) {
-			_rootNode->enablePhysics(false);
-			if(_buildAnchor.get() != nullptr) _buildAnchor->setEnabled(false);
-		}
+		loadDesign(dir.c_str());
 	}
 }
 
+//load the design saved in a directory or URL and build its physics
+bool Project::loadDesign(const char *dir) {
+	if(!_rootNode->loadData(dir, false)) return false;
+	_rootNode->setRest();
+	_rootNode->updateMaterial(true);
+	short n = _elements.size(), i;
+	app->getPhysicsController()->beginBatch();
+	for(i = 0; i < n; i++) {
+		Element *el = _elements[i].get();
+		short m = el->_nodes.size(), j;
+		for(j = 0; j < m; j++) el->addPhysics((j+1)%m); //"other" is first in list but should be done last
+	}
+	app->getPhysicsController()->endBatch();
+	if(app->getActiveMode() != this) {
+		_rootNode->enablePhysics(false);
+		if(_buildAnchor.get() != nullptr) _buildAnchor->setEnabled(false);
+	}
+	return true;
+}
+
 //just identify my payload, if any - will be positioned according to project
 bool Project::positionPayload() {
 	MyNode *root = app->getProjectNode(_payloadId);
@@ -889,7 +938,7 @@ void Project::Element::addNode() {
 		if(_numNodes > 1 || _multiple) do {
 			os.str("");
 			os << _project->_nodeId << "_" << _id << ++count;
-		} while (_project->_scene->findNode(os.str().c_str()) != NULL);
+		} while (app->lookupNode(os.str(), _project->_scene) != NULL);
 		else os << _project->_nodeId << "_" << _id;
 		node->setId(os.str().c_str());
 		if(append) _nodes.push_back(std::shared_ptr<MyNode>(node));
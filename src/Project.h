@@ -5,7 +5,8 @@
 
 namespace T4T {
 
-class Project : public Mode, public PhysicsController::Listener
+class Project : public Mode, public PhysicsController::Listener, public PhysicsController::TickListener,
+  public PhysicsController::ConstraintListener
 {
 public:
 	//component is divided into elements, eg. a lever has a base and arm
@@ -111,7 +112,8 @@ public:
 	     _launchComplete, _broken,
          _showGround; //if we should display the workbench when testing
 	     
-	unsigned int _launchSteps;
+	unsigned int _launchSteps; //physics steps since launch
+	PhysicsSnapshot _launchSnapshot; //state at the first step of the last launch, for retrying it
 	     
 	const char *_currentNodeId; //when attaching general items (not for a specific element)
 	
@@ -120,6 +122,7 @@ public:
 	Project(const char* id, const char *name);
 
 	virtual void sync();
+	bool loadDesign(const char *dir);
 	virtual void setupMenu();
     void hideButtons();
 	void setActive(bool active);
@@ -150,11 +153,14 @@ public:
 	virtual void addPhysics();
 	virtual void deleteSelected();
 	virtual void launch();
+	virtual void relaunch();
 	virtual void activate();
 	virtual void launchComplete();
 	virtual bool positionPayload();
 	virtual bool removePayload();
 	void statusEvent(PhysicsController::Listener::EventType type);
+	virtual void physicsTick(float timeStep);
+	void constraintBroken(PhysicsConstraint *constraint);
 };
 
 }
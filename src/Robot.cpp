@@ -14,7 +14,7 @@ Robot::Robot() : Project::Project("robot", "Robot") {
 	for(i = 0; i < n; i++) {
 		_robot->loadAnimation("res/common/robot.animation", _animations[i].c_str());
 	}
-	setupMenu();
+	if(!app->_headless) setupMenu();
 	
 	_buildState->set(30, 0, M_PI/2);
 	_testState->set(25, 0, M_PI/4);
@@ -17,7 +17,7 @@ Rocket::Rocket() : Project::Project("rocket", "Balloon Rocket") {
 	_pathLength = 10;
 	_straw = (Straw*) addElement(new Straw(this));
 	_balloons = (Balloon*) addElement(new Balloon(this, _straw));
-	setupMenu();
+	if(!app->_headless) setupMenu();
 }
 
 void Rocket::setActive(bool active) {
@@ -106,6 +106,11 @@ void Rocket::launch() {
 	}
 }
 
+void Rocket::relaunch() {
+	Project::relaunch(); //balloons are back to full size
+	_deflating = true;
+}
+
 void Rocket::update() {
 	if(!_launching) return;
 	//see if we made it to the end
@@ -113,7 +118,12 @@ void Rocket::update() {
 	if(maxZ > 0.99f * _pathLength/2) {
 		app->message("You made it to the end!");
 	}
-	//deflate each balloon by a fixed percentage
+}
+
+void Rocket::physicsTick(float timeStep) {
+	Project::physicsTick(timeStep);
+	if(!_launching) return;
+	//deflate each balloon by a fixed percentage per step
 	if(!_deflating) return;
 	_deflating = false;
 	short n = _balloons->_nodes.size();
@@ -131,7 +141,8 @@ void Rocket::update() {
 			Vector3 force = Vector3::unitZ();
 			balloon->getWorldMatrix().transformVector(&force);
 			force *= 200 * scale;
-			((PhysicsRigidBody*)anchor->getCollisionObject())->applyForce(force);
+			//forces last until the end of the frame, so apply this step's share as an impulse
+			((PhysicsRigidBody*)anchor->getCollisionObject())->applyImpulse(force * timeStep);
 			cout << "applied force " << app->pv(force) << endl;
 		}
 	}
@@ -176,7 +187,7 @@ Rocket::Straw::Straw(Project *project)
   
 void Rocket::Straw::addPhysics(short n) {
 
-	BoundingBox box = getNode()->getModel()->getMesh()->getBoundingBox();
+	BoundingBox box = getNode()->getMeshBox();
 	Rocket *rocket = (Rocket*)_project;
 	rocket->_strawLength = box.max.z - box.min.z;
 	rocket->_originalStrawLength = rocket->_strawLength;
@@ -216,6 +227,7 @@ bool Rocket::Straw::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int
 				strawInv.transformVector(&trans);
 				float scale = ((rocket->_strawLength/2 - trans.z) / rocket->_strawLength) * node->getScaleZ();
 				node->setScaleZ(scale);
+				node->updateCollisionShape(false);
 				rocket->_strawLength = rocket->_originalStrawLength * scale;
 			}
 		}
@@ -245,7 +257,7 @@ void Rocket::Balloon::placeNode(short n) {
 		//constrain the balloon so it is fixed to the straw
 		const char *id = balloon->getId();
 		anchor = MyNode::create(MyNode::concat(2, "rocket_anchor_", &id[7]));
-		BoundingBox box = balloon->getModel()->getMesh()->getBoundingBox();
+		BoundingBox box = balloon->getMeshBox();
 		float balloonRadius = (box.max.x - box.min.x) / 2;
 		float anchorRadius = balloonRadius * 0.5f; //best fit to the balloon shape as it deflates?
 		anchor->_objType = "sphere";
@@ -277,7 +289,7 @@ void Rocket::Balloon::addPhysics(short n) {
 	MyNode *straw = ((Rocket*)_project)->_straw->getNode(), *balloon = _nodes[n].get(),
 	  *anchor = dynamic_cast<MyNode*>(balloon->getParent());
 
-	BoundingBox box = balloon->getModel()->getMesh()->getBoundingBox();
+	BoundingBox box = balloon->getMeshBox();
 	float balloonRadius = (box.max.x - box.min.x) / 2, anchorRadius = balloonRadius * 0.5f;
 	if(_balloonRadius.size() <= n) {
 		_balloonRadius.resize(n+1);
@@ -45,7 +45,9 @@ public:
 	bool positionPayload();
 	bool removePayload();
 	void launch();
+	void relaunch();
 	void update();
+	void physicsTick(float timeStep);
 	void launchComplete();
 	void controlEvent(Control *control, Control::Listener::EventType evt);
 	bool touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex);
@@ -8,7 +8,7 @@ Satellite::Satellite() : Project::Project("satellite", "Satellite") {
 
 	_body = (Body*) addElement(new Body(this));
 	_instruments = (Instrument*) addElement(new Instrument(this, _body));
-	setupMenu();
+	if(!app->_headless) setupMenu();
 
 	_testState->set(40, M_PI/4, M_PI/3);
 
@@ -47,13 +47,13 @@ bool Satellite::setSubMode(short mode) {
 			}
 			if(maxRadius > _maxRadius || (maxZ - minZ) > _maxLength) {
 				app->message("Satellite does not fit in tube");
-				_launchButton->setEnabled(false);
+				if(_launchButton) _launchButton->setEnabled(false);
 				break;
 			}
 			//check that the mass is within the limit
 			if(_instruments->getTotalMass() > _instruments->_maxMass) {
 				app->message("Instruments are more than 60kg");
-				_launchButton->setEnabled(false);
+				if(_launchButton) _launchButton->setEnabled(false);
 				break;
 			}
 			//place it at a height of 1m
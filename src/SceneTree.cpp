@@ -0,0 +1,220 @@
+#include "T4TApp.h"
+#include "SceneTree.h"
+#include "MyNode.h"
+
+namespace T4T {
+
+SceneTree::SceneTree() : _root(-1), _free(-1), _margin(0.1f) {
+}
+
+void SceneTree::clear() {
+	_nodes.clear();
+	_moved.clear();
+	_root = -1;
+	_free = -1;
+}
+
+int SceneTree::allocate() {
+	int index = _free;
+	if(index >= 0) _free = _nodes[index].parent;
+	else {
+		index = _nodes.size();
+		_nodes.push_back(TreeNode());
+	}
+	TreeNode &n = _nodes[index];
+	n.parent = n.left = n.right = -1;
+	n.node = NULL;
+	n.moved = false;
+	return index;
+}
+
+void SceneTree::release(int index) {
+	_nodes[index].node = NULL;
+	_nodes[index].parent = _free;
+	_free = index;
+}
+
+//the node's current box in world space - from its model space box, so it follows physics without new world vertices
+BoundingBox SceneTree::getNodeBox(MyNode *node) {
+	BoundingBox box = node->_localBox;
+	if(box.isEmpty()) {
+		float r = node->_radius;
+		box.set(Vector3(-r, -r, -r), Vector3(r, r, r));
+	}
+	box.transform(node->getWorldMatrix());
+	return box;
+}
+
+float SceneTree::area(const BoundingBox &box) {
+	Vector3 d = box.max - box.min;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+bool SceneTree::encloses(const BoundingBox &outer, const BoundingBox &inner) {
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+	  && outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+//slab test of the ray segment from 0 to distance
+bool SceneTree::rayHits(const BoundingBox &box, const Vector3 &origin, const Vector3 &direction, float distance) {
+	const float o[3] = {origin.x, origin.y, origin.z}, d[3] = {direction.x, direction.y, direction.z},
+		lo[3] = {box.min.x, box.min.y, box.min.z}, hi[3] = {box.max.x, box.max.y, box.max.z};
+	float tmin = 0, tmax = distance, t1, t2;
+	for(short i = 0; i < 3; i++) {
+		if(fabs(d[i]) < 1e-12f) {
+			if(o[i] < lo[i] || o[i] > hi[i]) return false;
+			continue;
+		}
+		t1 = (lo[i] - o[i]) / d[i];
+		t2 = (hi[i] - o[i]) / d[i];
+		if(t1 > t2) std::swap(t1, t2);
+		tmin = fmax(tmin, t1);
+		tmax = fmin(tmax, t2);
+		if(tmin > tmax) return false;
+	}
+	return true;
+}
+
+int SceneTree::insert(MyNode *node) {
+	int leaf = allocate();
+	Vector3 margin(_margin, _margin, _margin);
+	BoundingBox box = getNodeBox(node);
+	_nodes[leaf].node = node;
+	_nodes[leaf].box.set(box.min - margin, box.max + margin);
+	insertLeaf(leaf);
+	return leaf;
+}
+
+void SceneTree::remove(int leaf) {
+	removeLeaf(leaf);
+	release(leaf);
+}
+
+//true if the given leaf is still the one holding this node
+bool SceneTree::contains(int leaf, MyNode *node) {
+	return leaf >= 0 && leaf < _nodes.size() && _nodes[leaf].node == node;
+}
+
+void SceneTree::touch(int leaf) {
+	if(_nodes[leaf].moved) return;
+	_nodes[leaf].moved = true;
+	_moved.push_back(leaf);
+}
+
+//redo the boxes of moved nodes - a leaf is only reinserted once its node leaves the padded box
+void SceneTree::refit() {
+	Vector3 margin(_margin, _margin, _margin);
+	int n = _moved.size(), i;
+	for(i = 0; i < n; i++) {
+		int leaf = _moved[i];
+		if(!_nodes[leaf].node || !_nodes[leaf].moved) continue;
+		_nodes[leaf].moved = false;
+		BoundingBox box = getNodeBox(_nodes[leaf].node);
+		if(encloses(_nodes[leaf].box, box)) continue;
+		removeLeaf(leaf);
+		_nodes[leaf].box.set(box.min - margin, box.max + margin);
+		insertLeaf(leaf);
+	}
+	_moved.clear();
+}
+
+//walk down to the sibling that grows the total box area least, then pair the leaf with it
+void SceneTree::insertLeaf(int leaf) {
+	if(_root < 0) {
+		_root = leaf;
+		_nodes[leaf].parent = -1;
+		return;
+	}
+	BoundingBox box = _nodes[leaf].box, merged;
+	int index = _root;
+	while(_nodes[index].left >= 0) {
+		const TreeNode &n = _nodes[index];
+		merged = n.box;
+		merged.merge(box);
+		float cost = 2 * area(merged), inherit = 2 * (area(merged) - area(n.box)), childCost[2];
+		int child[2] = {n.left, n.right};
+		for(short i = 0; i < 2; i++) {
+			merged = _nodes[child[i]].box;
+			merged.merge(box);
+			childCost[i] = area(merged) + inherit;
+			if(_nodes[child[i]].left >= 0) childCost[i] -= area(_nodes[child[i]].box);
+		}
+		if(cost < childCost[0] && cost < childCost[1]) break;
+		index = childCost[0] < childCost[1] ? child[0] : child[1];
+	}
+	int sibling = index, oldParent = _nodes[sibling].parent, parent = allocate();
+	_nodes[parent].parent = oldParent;
+	_nodes[parent].left = sibling;
+	_nodes[parent].right = leaf;
+	_nodes[sibling].parent = parent;
+	_nodes[leaf].parent = parent;
+	if(oldParent < 0) _root = parent;
+	else if(_nodes[oldParent].left == sibling) _nodes[oldParent].left = parent;
+	else _nodes[oldParent].right = parent;
+	refitUp(parent);
+}
+
+//the leaf's sibling takes its parent's place
+void SceneTree::removeLeaf(int leaf) {
+	if(leaf == _root) {
+		_root = -1;
+		return;
+	}
+	int parent = _nodes[leaf].parent, grandParent = _nodes[parent].parent,
+		sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+	_nodes[sibling].parent = grandParent;
+	if(grandParent < 0) _root = sibling;
+	else {
+		if(_nodes[grandParent].left == parent) _nodes[grandParent].left = sibling;
+		else _nodes[grandParent].right = sibling;
+		refitUp(grandParent);
+	}
+	release(parent);
+}
+
+void SceneTree::refitUp(int index) {
+	for(; index >= 0; index = _nodes[index].parent) {
+		TreeNode &n = _nodes[index];
+		n.box = _nodes[n.left].box;
+		n.box.merge(_nodes[n.right].box);
+	}
+}
+
+void SceneTree::queryBox(const BoundingBox &box, std::vector<MyNode*> &nodes) {
+	if(_root < 0) return;
+	_stack.clear();
+	_stack.push_back(_root);
+	while(!_stack.empty()) {
+		const TreeNode &n = _nodes[_stack.back()];
+		_stack.pop_back();
+		if(!n.box.intersects(box)) continue;
+		if(n.left < 0) nodes.push_back(n.node);
+		else {
+			_stack.push_back(n.left);
+			_stack.push_back(n.right);
+		}
+	}
+}
+
+void SceneTree::queryPoint(const Vector3 &point, std::vector<MyNode*> &nodes) {
+	queryBox(BoundingBox(point, point), nodes);
+}
+
+void SceneTree::queryRay(const Ray &ray, float distance, std::vector<MyNode*> &nodes) {
+	if(_root < 0) return;
+	const Vector3 &origin = ray.getOrigin(), &direction = ray.getDirection();
+	_stack.clear();
+	_stack.push_back(_root);
+	while(!_stack.empty()) {
+		const TreeNode &n = _nodes[_stack.back()];
+		_stack.pop_back();
+		if(!rayHits(n.box, origin, direction, distance)) continue;
+		if(n.left < 0) nodes.push_back(n.node);
+		else {
+			_stack.push_back(n.left);
+			_stack.push_back(n.right);
+		}
+	}
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef SCENETREE_H_
+#define SCENETREE_H_
+
+#include "gameplay.h"
+#include <vector>
+
+using namespace gameplay;
+
+namespace T4T {
+
+class MyNode;
+
+//dynamic bounding volume tree over scene nodes, kept apart from the physics world so it also sees nodes whose physics
+//is off.  Each leaf holds a node's box padded by a margin, so small moves leave the tree alone, and a moved node is only
+//flagged - its leaf is refit before the next query.
+class SceneTree {
+public:
+	SceneTree();
+	void clear();
+	int insert(MyNode *node);
+	void remove(int leaf);
+	bool contains(int leaf, MyNode *node);
+	void touch(int leaf);
+	void refit();
+
+	//queries add every node whose padded box meets the shape - the caller makes any exact test
+	void queryBox(const BoundingBox &box, std::vector<MyNode*> &nodes);
+	void queryPoint(const Vector3 &point, std::vector<MyNode*> &nodes);
+	void queryRay(const Ray &ray, float distance, std::vector<MyNode*> &nodes);
+
+	static BoundingBox getNodeBox(MyNode *node);
+
+private:
+	struct TreeNode {
+		BoundingBox box;
+		int parent; //next free slot when this one is unused
+		int left, right; //-1 for a leaf
+		MyNode *node; //NULL unless this is a leaf
+		bool moved;
+	};
+	std::vector<TreeNode> _nodes;
+	std::vector<int> _moved, _stack;
+	int _root, _free;
+	float _margin;
+
+	int allocate();
+	void release(int index);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	void refitUp(int index);
+	static float area(const BoundingBox &box);
+	static bool encloses(const BoundingBox &outer, const BoundingBox &inner);
+	static bool rayHits(const BoundingBox &box, const Vector3 &origin, const Vector3 &direction, float distance);
+};
+
+}
+
+#endif
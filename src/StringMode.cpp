@@ -10,6 +10,7 @@ StringMode::StringMode() : Mode::Mode("string") {
 	_pathNode->setColor(1.0f, 0.0f, 0.0f);
 	_pathNode->_chain = true;
 	_pathNode->_lineWidth = 10.0f;
+	_pathNode->setTag("helper");
 	
 	_stringTemplate = MyNode::create("string");
 	_stringTemplate->_type = "root";
@@ -273,6 +274,7 @@ void StringMode::makeString() {
 	os << "string" << ++_stringTemplate->_typeCount;
 	_stringNode->setId(os.str().c_str());
 	n = _links.size();
+	app->getPhysicsController()->beginBatch();
 	for(i = 0; i < n; i++) {
 		_stringNode->addChild(_links[i]);
 		_links[i]->addPhysics();
@@ -287,6 +289,7 @@ void StringMode::makeString() {
 		Vector3 joint3 = plane2World(joint), axis3 = plane2Vec(axis);
 		app->addConstraint(_links[i*(n-1)], _nodes[i*(_nodes.size()-1)]->_node, -1, "socket", joint3, axis3);
 	}
+	app->getPhysicsController()->endBatch();
 	enableString(false);
 	_scene->removeNode(_pathNode);
 	_scene->addNode(_stringNode);
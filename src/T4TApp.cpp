@@ -15,6 +15,11 @@
 #include "CEV.h"
 #include "Launcher.h"
 #include "HullMode.h"
+#ifndef WIN32
+	#include <unistd.h>
+	#include <sys/wait.h>
+	#include <errno.h>
+#endif
 
 namespace T4T {
 
@@ -29,10 +34,21 @@ enum RenderQueue {
 	QUEUE_COUNT
 };
 
+static bool compareMaterials(const T4TApp::RenderItem &a, const T4TApp::RenderItem &b) {
+	if(a.effect != b.effect) return a.effect < b.effect;
+	if(a.model->getMesh() != b.model->getMesh()) return a.model->getMesh() < b.model->getMesh();
+	return a.material < b.material;
+}
+
 T4TApp::T4TApp()
-    : _scene(NULL)
+    : _scene(NULL), _transformFlusher(NULL)
 {
 	__t4tInstance = this;
+#ifdef T4T_HEADLESS
+	_headless = true;
+#else
+	_headless = false;
+#endif
 }
 
 void T4TApp::debugTrigger()
@@ -47,6 +63,18 @@ T4TApp* T4TApp::getInstance() {
 void T4TApp::initialize()
 {
 	_hasInternet = true;
+	_materialProps = NULL;
+	_renderDirty = true;
+	_nodeIndexDirty = true;
+	_nodeIndexScene = NULL;
+	_sceneTreeDirty = true;
+	_physicsMesh = NULL;
+	_transformFlusher = new TransformFlusher(this);
+	getPhysicsController()->addTickListener(_transformFlusher);
+	if(_headless) {
+		initHeadless();
+		return;
+	}
 	
 	// Load font
 	_font = Font::create("res/common/fonts/arial-distance.gpb");
@@ -246,6 +274,14 @@ void T4TApp::initialize()
     _action = NULL;
     _tmpNode = MyNode::create("tmpNode");
     _tmpCount = 0;
+    //the oldest actions are dropped once undo/redo holds more than "undo.budget" megabytes
+    Properties *undo = getConfig()->getNamespace("undo", true);
+    _historyBudget = (size_t)((undo && undo->exists("budget") ? undo->getFloat("budget") : 64.0f) * 1048576);
+    _historyBytes = 0;
+    //the journal is folded into a full save every "journal.compact" entries
+    Properties *journal = getConfig()->getNamespace("journal", true);
+    _journalCompact = journal && journal->exists("compact") ? journal->getInt("compact") : 50;
+    _journalEntries = 0;
 
     //exclude certain nodes (eg. ground, camera) from being selected by touches
     _hitFilter = new HitFilter(this);
@@ -255,11 +291,14 @@ void T4TApp::initialize()
 	_face = MyNode::create("face");
 	_face->_wireframe = true;
 	_face->_lineWidth = 5.0f;
+	_face->setTag("helper");
 	_edge = MyNode::create("edge");
 	_edge->_wireframe = true;
 	_edge->_lineWidth = 5.0f;
+	_edge->setTag("helper");
 	_vertex = duplicateModelNode("sphere");
 	if(_vertex) {
+		_vertex->setTag("helper");
 		_vertex->setScale(0.15f);
 		_vertex->getModel()->setMaterial("res/common/models.material#colored");
 		_vertex->setColor(1.0f, 0.0f, 0.0f);
@@ -320,6 +359,7 @@ void T4TApp::drawSplash(void* param)
 }
 
 void T4TApp::splash(const char *msg) {
+	if(_headless) return;
 	displayScreen(this, &T4TApp::drawSplash, (void*)msg, 10L);
 }
 
@@ -340,14 +380,347 @@ void T4TApp::free() {
 	//while(!_constraints.empty()) _constraints.erase(_constraints.begin());
 	//Rocket *rocket = (Rocket*) getProject("rocket");
 	//if(rocket && rocket->_straw) rocket->_straw->_constraint.reset();
+	clearRenderQueues();
 	SAFE_RELEASE(_scene);
 	SAFE_RELEASE(_mainMenu);
+	SAFE_DELETE(_materialProps);
+	SAFE_RELEASE(_physicsMesh);
+	SAFE_DELETE(_transformFlusher);
 }
 
 T4TApp::~T4TApp() {
 	free();
 }
 
+//physics-only startup: build the scene, model catalog and projects with no UI or GL models, then run the scene
+//or batch named in the "headless" section of game.config and exit
+void T4TApp::initHeadless()
+{
+	_mainMenu = NULL;
+	_activeMode = -1;
+	_navMode = -1;
+	_activeScene = NULL;
+	_hasInternet = false; //models and designs are read from local files
+	_face = MyNode::create("face");
+	_face->setTag("helper");
+	_edge = MyNode::create("edge");
+	_edge->setTag("helper");
+	_vertex = NULL;
+
+	//mesh collision shapes are built from node hulls - they only need a mesh handle to carry them, with no GL buffer
+	VertexFormat::Element position(VertexFormat::POSITION, 3);
+	_physicsMesh = Mesh::createEmpty(VertexFormat(&position, 1));
+
+	initScene();
+	loadModels();
+	_modes.push_back(new Satellite());
+	_modes.push_back(new Rocket());
+	_modes.push_back(new Buggy());
+	_modes.push_back(new Robot());
+	_modes.push_back(new LandingPod());
+	_modes.push_back(new CEV());
+	_modes.push_back(new Launcher());
+
+	Properties *config = getConfig()->getNamespace("headless", true);
+	const char *scene = config ? config->getString("scene") : NULL;
+	float duration = config && config->exists("duration") ? config->getFloat("duration") : 10.0f,
+		rate = config && config->exists("rate") ? config->getFloat("rate") : 60.0f;
+	Properties *batch = config ? config->getNamespace("batch", true, false) : NULL;
+	if(batch) runBatch(batch, duration, 1.0f / rate);
+	else {
+		if(scene) loadScene(scene);
+		else GP_WARN("No scene specified in game.config headless section");
+		simulate(duration, 1.0f / rate);
+	}
+	exit();
+}
+
+//counts constraints that break during a batch launch
+class BreakCounter : public PhysicsController::ConstraintListener {
+public:
+	int _count;
+	BreakCounter() : _count(0) {}
+	void constraintBroken(PhysicsConstraint *constraint) { _count++; }
+};
+
+static Vector3 getBodyCentroid(std::vector<MyNode*> &nodes) {
+	Vector3 center = Vector3::zero();
+	for(short i = 0; i < nodes.size(); i++) center += nodes[i]->getTranslationWorld();
+	return center * (1.0f / nodes.size());
+}
+
+//load a project's saved design for a batch job, with its payload's design from the same directory if that was saved too
+//a project keeps the first design it loads, so jobs trying another one need worker processes of their own
+bool T4TApp::loadBatchDesign(Project *project, std::string dir)
+{
+	if(dir.empty()) {
+		GP_WARN("No design directory given for project %s", project->getId());
+		return false;
+	}
+	if(dir[dir.length()-1] != '/') dir += "/";
+	std::map<std::string, std::string>::iterator it = _batchDesigns.find(project->getId());
+	if(it != _batchDesigns.end()) {
+		if(it->second == dir) return true;
+		GP_WARN("Project %s already holds the design from %s", project->getId(), it->second.c_str());
+		return false;
+	}
+	std::string file = dir + project->getId() + ".node";
+	if(!FileSystem::fileExists(file.c_str())) {
+		GP_WARN("No saved %s design in %s", project->getId(), dir.c_str());
+		return false;
+	}
+	if(!project->loadDesign(dir.c_str())) return false;
+	_batchDesigns[project->getId()] = dir;
+	Project *payload = project->_payloadId ? getProject(project->_payloadId) : NULL;
+	if(payload) loadBatchDesign(payload, dir);
+	return true;
+}
+
+//run one job and see how far it got - job keys:
+//  project, design: launch a project's design saved in the design directory, as its Launch button would
+//  scene: drop a saved scene with no project in and let it settle
+//  node plus scale/translation: vary one node before the run, eg. a balloon on the rocket straw
+//  rampHeight (buggy), stretch (launcher): how the project is set up for the launch
+T4TApp::LaunchResult T4TApp::evaluateLaunch(Properties *job, float duration, float timeStep)
+{
+	LaunchResult result;
+	result.name = job->getId();
+	result.distance = 0;
+	result.broken = false;
+	result.success = false;
+	double start = getAbsoluteTime();
+	const char *projectId = job->getString("project"), *scene = job->getString("scene"), *nodeId = job->getString("node");
+	Project *project = NULL;
+	short i;
+	if(projectId) {
+		project = getProject(projectId);
+		if(!project) GP_WARN("Batch job %s has no project %s", job->getId(), projectId);
+		else if(!loadBatchDesign(project, job->getString("design", ""))) project = NULL;
+		if(project) {
+			for(i = 0; i < _modes.size() && _modes[i] != project; i++);
+			setMode(i);
+			project->setSubMode(1);
+			if(!project->_complete) {
+				GP_WARN("The %s design for batch job %s is incomplete", projectId, job->getId());
+				setMode(-1);
+				project = NULL;
+			}
+		}
+		if(!project) {
+			result.broken = true;
+			result.wallTime = getAbsoluteTime() - start;
+			return result;
+		}
+	} else if(scene) loadScene(scene);
+	else GP_WARN("No project or scene specified for batch job %s", job->getId());
+	if(nodeId) {
+		MyNode *node = lookupNode(nodeId);
+		Vector3 vec;
+		if(!node) GP_WARN("Batch job %s has no node %s", job->getId(), nodeId);
+		else {
+			if(job->getVector3("scale", &vec)) node->setScale(vec);
+			if(job->getVector3("translation", &vec)) node->setTranslation(vec);
+			node->updateCollisionShape();
+		}
+	}
+	Buggy *buggy = dynamic_cast<Buggy*>(project);
+	if(buggy && job->exists("rampHeight")) buggy->setRampHeight(job->getFloat("rampHeight"));
+	Launcher *launcher = dynamic_cast<Launcher*>(project);
+	if(launcher && job->exists("stretch")) launcher->setStretch(job->getFloat("stretch"));
+	//measure from where each moving model starts - a project's root node has no body of its own,
+	//so each tree is tracked by the centroid of its dynamic bodies; a launch tracks its payload if it has one
+	std::vector<MyNode*> roots;
+	if(project) roots.push_back(project->_payload ? project->_payload : project->_rootNode);
+	else for(Node *n = _scene->getFirstNode(); n != NULL; n = n->getNextSibling()) {
+		MyNode *root = dynamic_cast<MyNode*>(n);
+		if(root) roots.push_back(root);
+	}
+	std::vector<std::vector<MyNode*> > models;
+	std::vector<Vector3> starts;
+	for(short r = 0; r < roots.size(); r++) {
+		std::vector<MyNode*> nodes = roots[r]->getAllNodes(), bodies;
+		for(i = 0; i < nodes.size(); i++) {
+			if(!nodes[i]->isStatic() && nodes[i]->getCollisionObject()) bodies.push_back(nodes[i]);
+		}
+		if(bodies.empty()) continue;
+		models.push_back(bodies);
+		starts.push_back(getBodyCentroid(bodies));
+	}
+	BreakCounter breaks;
+	getPhysicsController()->addConstraintListener(&breaks);
+	if(project) project->launch();
+	simulate(duration, timeStep);
+	getPhysicsController()->removeConstraintListener(&breaks);
+	float front = -MyNode::inf();
+	for(short m = 0; m < models.size(); m++) {
+		Vector3 delta = getBodyCentroid(models[m]) - starts[m];
+		delta.y = 0;
+		result.distance = fmax(result.distance, delta.length());
+		for(i = 0; i < models[m].size(); i++) {
+			MyNode *node = models[m][i];
+			node->updateTransform();
+			front = fmax(front, node->getMaxValue(Vector3::unitZ()) + node->getTranslationWorld().z);
+		}
+	}
+	if(project) {
+		//the project's own test: nothing broke off, and it crossed the finish line if it has one
+		result.broken = project->_broken;
+		result.success = !result.broken && (project->_finishDistance <= 0 || front > project->_finishDistance);
+		setMode(-1);
+	} else {
+		result.broken = breaks._count > 0;
+		result.success = !result.broken;
+	}
+	result.wallTime = getAbsoluteTime() - start;
+	return result;
+}
+
+//run every job in the "batch" section - each in its own process, so each gets an isolated physics world
+//and the runs spread across cores; "workers" caps how many run at once (default: one per core)
+void T4TApp::runBatch(Properties *batch, float duration, float timeStep)
+{
+	std::vector<Properties*> jobs;
+	Properties *job;
+	while((job = batch->getNextNamespace()) != NULL) jobs.push_back(job);
+	std::vector<LaunchResult> results(jobs.size());
+	short n = jobs.size(), i = 0;
+	int workers = batch->exists("workers") ? batch->getInt("workers") : 0;
+	Properties *physics = getConfig()->getNamespace("physics", true);
+	if(physics && physics->getBool("multithreaded")) {
+		//the solver's worker threads do not survive a fork
+		GP_WARN("Batch jobs run one at a time when physics is multithreaded");
+		workers = 1;
+	}
+	double start = getAbsoluteTime();
+#ifndef WIN32
+	if(workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(workers > 1) {
+		std::map<pid_t, std::pair<short, int> > running; //worker => job index, read end of its pipe
+		bool forking = true; //until a fork fails - a job run here would leave its world behind in every later worker
+		while((forking && i < n) || !running.empty()) {
+			if(forking && i < n && running.size() < (size_t)workers) {
+				int fd[2];
+				pid_t pid = -1;
+				bool piped = pipe(fd) == 0;
+				cout.flush();
+				if(piped) pid = fork();
+				if(pid == 0) {
+					close(fd[0]);
+					LaunchResult result = evaluateLaunch(jobs[i], duration, timeStep);
+					std::ostringstream os;
+					os << result.distance << " " << result.broken << " " << result.success << " " << result.wallTime << endl;
+					std::string line = os.str();
+					const char *data = line.c_str();
+					size_t left = line.length();
+					while(left > 0) {
+						ssize_t written = write(fd[1], data, left);
+						if(written < 0 && errno == EINTR) continue;
+						if(written <= 0) _exit(1);
+						data += written;
+						left -= written;
+					}
+					_exit(0);
+				}
+				if(pid < 0) {
+					//no more workers - the remaining jobs run here once the running ones finish
+					if(piped) {
+						close(fd[0]);
+						close(fd[1]);
+					}
+					GP_WARN("Could not start a batch worker - running the remaining jobs one at a time");
+					forking = false;
+					continue;
+				}
+				close(fd[1]);
+				running[pid] = std::make_pair(i++, fd[0]);
+				continue;
+			}
+			int status;
+			pid_t pid = waitpid(-1, &status, 0);
+			if(pid < 0) {
+				if(errno == EINTR) continue;
+				//no children left to wait for - whatever has not reported is lost
+				for(std::map<pid_t, std::pair<short, int> >::iterator it = running.begin(); it != running.end(); it++) {
+					close(it->second.second);
+					LaunchResult &result = results[it->second.first];
+					result.name = jobs[it->second.first]->getId();
+					result.distance = 0;
+					result.broken = true;
+					result.success = false;
+					result.wallTime = 0;
+					GP_WARN("Batch job %s did not finish", result.name.c_str());
+				}
+				running.clear();
+				continue;
+			}
+			if(running.find(pid) == running.end()) continue;
+			short ind = running[pid].first;
+			int fd = running[pid].second;
+			running.erase(pid);
+			char buf[256];
+			ssize_t len = 0, got;
+			while(len < (ssize_t)sizeof(buf) - 1 && ((got = read(fd, buf + len, sizeof(buf) - 1 - len)) > 0
+			  || (got < 0 && errno == EINTR))) {
+				if(got > 0) len += got;
+			}
+			close(fd);
+			LaunchResult &result = results[ind];
+			result.name = jobs[ind]->getId();
+			result.distance = 0;
+			result.broken = true;
+			result.success = false;
+			result.wallTime = 0;
+			if(len > 0) {
+				buf[len] = '\0';
+				std::istringstream in(buf);
+				in >> result.distance >> result.broken >> result.success >> result.wallTime;
+			} else GP_WARN("Batch job %s did not finish", result.name.c_str());
+		}
+	}
+#endif
+	//jobs not handed to a worker process run here
+	for(; i < n; i++) results[i] = evaluateLaunch(jobs[i], duration, timeStep);
+	double elapsed = getAbsoluteTime() - start;
+	cout << "batch results:" << endl;
+	for(i = 0; i < n; i++) {
+		cout << "  " << results[i].name << ": " << (results[i].success ? "succeeded" : "failed")
+		  << ", distance " << results[i].distance << (results[i].broken ? ", broke" : ", intact")
+		  << ", " << results[i].wallTime << "ms" << endl;
+	}
+	cout << n << " jobs in " << elapsed << "ms" << endl;
+}
+
+//physics runs in fixed steps so launches play out the same at any frame rate - "physics" section of game.config
+void T4TApp::initTimeStep()
+{
+	Properties *config = getConfig()->getNamespace("physics", true);
+	float rate = config && config->exists("rate") ? config->getFloat("rate") : 60.0f;
+	int maxSubSteps = config && config->exists("maxSubSteps") ? config->getInt("maxSubSteps") : 10;
+	if(rate <= 0) {
+		GP_WARN("Physics rate must be positive - using 60");
+		rate = 60.0f;
+	}
+	if(maxSubSteps < 1) {
+		GP_WARN("Physics maxSubSteps must be at least 1 - using 1");
+		maxSubSteps = 1;
+	}
+	getPhysicsController()->setTimeStep(1.0f / rate, maxSubSteps);
+}
+
+//step the physics at a fixed rate, as fast as possible, running the active mode's frame logic after each step
+void T4TApp::simulate(float duration, float timeStep)
+{
+	getPhysicsController()->setTimeStep(timeStep, 1);
+	unsigned int steps = (unsigned int)(duration / timeStep + 0.5f), i;
+	double start = getAbsoluteTime(); //wall clock, for comparing physics configurations
+	for(i = 0; i < steps; i++) {
+		getPhysicsController()->step(timeStep * 1000.0f);
+		if(_activeMode >= 0) _modes[_activeMode]->update();
+	}
+	double elapsed = getAbsoluteTime() - start;
+	GP_WARN("simulated %u steps of %fs in %fms (%fms per step)", steps, timeStep, elapsed, steps > 0 ? elapsed / steps : 0);
+}
+
 void T4TApp::finalize()
 {
 	free();
@@ -356,6 +729,7 @@ void T4TApp::finalize()
 int updateCount = 0;
 void T4TApp::update(float elapsedTime)
 {
+	if(_headless) return;
 	if(_activeMode >= 0) _modes[_activeMode]->update();
     _mainMenu->update(elapsedTime);
     _projectMenu->update(elapsedTime);
@@ -364,6 +738,7 @@ void T4TApp::update(float elapsedTime)
 	short n = _forms.size(), i;
 	for(i = 0; i < n; i++) _forms[i]->_container->update(elapsedTime);
 	if(_carVehicle) _carVehicle->update(elapsedTime, _steering, _braking, _driving);
+	flushTransforms();
 }
 
 void T4TApp::setFinishLine(float distance) {
@@ -399,6 +774,7 @@ void T4TApp::setTooltip() {
 
 void T4TApp::render(float elapsedTime)
 {
+	if(_headless) return;
     // Clear the color and depth buffers
     clear(CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
     
@@ -429,10 +805,13 @@ void T4TApp::render(float elapsedTime)
 
     // Visit all the nodes in the scene for drawing
     if(_activeScene != NULL) {
-		for(short i = 0; i < QUEUE_COUNT; i++) {
-			_renderQueues[i].clear();
-		}
-    	_activeScene->visit(this, &T4TApp::buildRenderQueues);
+    	if(renderQueuesChanged()) {
+    		clearRenderQueues();
+	    	_activeScene->visit(this, &T4TApp::buildRenderQueues);
+	    	//group opaque draws by shader and material to cut down on state changes
+	    	std::sort(_renderQueues[QUEUE_OPAQUE].begin(), _renderQueues[QUEUE_OPAQUE].end(), compareMaterials);
+	    	_renderDirty = false;
+	    }
    	    drawScene();
 	   	if(_drawDebug) getPhysicsController()->drawDebug(_activeScene->getActiveCamera()->getViewProjectionMatrix());
     }
@@ -643,6 +1022,7 @@ void T4TApp::setNavMode(short mode) {
 		case 1: modes->setActive("translate"); break;
 		case 2: modes->setActive("zoom"); break;
 	}
+    if(!touch) return;
     if(mode >= 0) touch->setActive("eye");
     else touch->setActive("hand");
 }
@@ -977,12 +1357,14 @@ void T4TApp::initScene()
     _finishLineWidth = 6.0f;
     _finishLineHeight = 2.0f;
     _finishLine = MyNode::create("finishLine");
-    Mesh *mesh = Mesh::createQuad(0, 0, _finishLineWidth, _finishLineHeight);
-    Model *model = Model::create(mesh);
-    model->setMaterial("res/common/models.material#finishLine");
-    SAFE_RELEASE(mesh);
-    _finishLine->setDrawable(model);
-    SAFE_RELEASE(model);
+    if(!_headless) {
+        Mesh *mesh = Mesh::createQuad(0, 0, _finishLineWidth, _finishLineHeight);
+        Model *model = Model::create(mesh);
+        model->setMaterial("res/common/models.material#finishLine");
+        SAFE_RELEASE(mesh);
+        _finishLine->setDrawable(model);
+        SAFE_RELEASE(model);
+    }
     _finishLine->setTag("transparent");
     _finishLine->setRotation(Vector3::unitY(), M_PI);
     _finishLine->rotate(Vector3::unitX(), -M_PI/2);
@@ -1034,6 +1416,7 @@ void T4TApp::initScene()
 
     _gravity.set(0, -10, 0);
     getPhysicsController()->setGravity(_gravity);
+    initTimeStep();
 
     setActiveScene(_scene);
     resetCamera();
@@ -1077,6 +1460,7 @@ void T4TApp::addItem(const char *type, std::vector<std::string> tags) {
 		node->setTag(tags[i].c_str());
 	}
 	_models->addNode(node);
+	if(_headless) return; //no catalog menu
 
 	std::string imageFile = "res/png/item_photos/";
 	imageFile += type;
@@ -1097,6 +1481,7 @@ void T4TApp::addItem(const char *type, std::vector<std::string> tags) {
 }
 
 void T4TApp::filterItemMenu(const char *tag) {
+	if(_headless) return;
 	for(Node *n = _models->getFirstNode(); n; n = n->getNextSibling()) {
 		MyNode *node = dynamic_cast<MyNode*>(n);
 		bool filtered = tag && !node->hasTag(tag);
@@ -1145,6 +1530,7 @@ void T4TApp::loadScene(const char *scene) {
 		ss >> id;
 		loadNode(id.c_str());
 	}
+	replayJournal();
 }
 
 MyNode* T4TApp::loadNode(const char *id) {
@@ -1158,10 +1544,10 @@ MyNode* T4TApp::loadNode(const char *id) {
 void T4TApp::saveScene(const char *scene) {
 	if(scene != NULL) setSceneName(scene);
 	//create a file that lists all root nodes in the scene, and save each one to its own file
-	std::string listFile = getSceneDir() + "scene.list", line;
-	std::unique_ptr<Stream> stream(FileSystem::open(listFile.c_str(), FileSystem::WRITE));
+	std::string listFile = getSceneDir() + "scene.list", tmpFile = listFile + ".tmp", line;
+	std::unique_ptr<Stream> stream(FileSystem::open(tmpFile.c_str(), FileSystem::WRITE));
 	if(stream.get() == NULL) {
-		GP_ERROR("Failed to open file '%s'", listFile.c_str());
+		GP_ERROR("Failed to open file '%s'", tmpFile.c_str());
 		return;
 	}
 	MyNode *node;
@@ -1178,6 +1564,14 @@ void T4TApp::saveScene(const char *scene) {
 		}
 	}
 	stream->close();
+	if(!FileSystem::renameFile(tmpFile.c_str(), listFile.c_str())) {
+		GP_WARN("Failed to replace file '%s'", listFile.c_str());
+		return;
+	}
+	//everything is in the scene files now, so the journal starts over
+	FILE *journal = FileSystem::openFile(getJournalFile().c_str(), "w");
+	if(journal) fclose(journal);
+	_journalEntries = 0;
 }
 
 bool T4TApp::saveNode(Node *n) {
@@ -1186,6 +1580,97 @@ bool T4TApp::saveNode(Node *n) {
 	return true;
 }
 
+std::string T4TApp::getJournalFile() {
+	return getSceneDir() + "journal";
+}
+
+//record the state an action - or its undo or redo - left each of its nodes in: a root node's transform if that is
+//all that changed, otherwise its whole file, or that it is no longer a root node in the scene
+void T4TApp::journalAction(Action *action) {
+	if(_headless || action->type.compare("test") == 0) return;
+	std::ostringstream os;
+	os.precision(9); //enough digits that a replayed transform is the one that was recorded
+	for(short i = 0; i < action->nodes.size(); i++) {
+		MyNode *node = action->nodes[i];
+		if(node->getScene() != _scene || node->getParent() != NULL) {
+			os << "remove " << node->getId() << endl;
+		} else if(action->type.compare("position") == 0) {
+			Vector3 translation = node->getTranslation(), scale = node->getScale();
+			Quaternion rotation = node->getRotation();
+			os << "move " << node->getId() << "\t" << translation.x << "\t" << translation.y << "\t" << translation.z
+			  << "\t" << rotation.x << "\t" << rotation.y << "\t" << rotation.z << "\t" << rotation.w
+			  << "\t" << scale.x << "\t" << scale.y << "\t" << scale.z << endl;
+		} else {
+			node->writeData(); //swapped in whole before the line naming it is written
+			os << "node " << node->getId() << endl;
+		}
+	}
+	writeJournal(os.str());
+}
+
+void T4TApp::writeJournal(const std::string &entry) {
+	std::string filename = getJournalFile();
+	FILE *journal = FileSystem::openFile(filename.c_str(), "a");
+	if(journal == NULL) {
+		GP_WARN("Failed to open journal '%s'", filename.c_str());
+		return;
+	}
+	fwrite(entry.c_str(), sizeof(char), entry.length(), journal);
+	fclose(journal);
+	if(++_journalEntries >= _journalCompact) saveScene();
+}
+
+//bring a freshly loaded scene up to date with what was done since it was last saved - only whole lines count,
+//so one cut short by a crash is skipped, as is a node whose file never made it to disk
+void T4TApp::replayJournal() {
+	std::unique_ptr<Stream> stream(FileSystem::open(getJournalFile().c_str()));
+	_journalEntries = 0;
+	if(stream.get() == NULL) return;
+	char line[256], *str;
+	std::string type, id;
+	std::istringstream ss;
+	float f[10];
+	short i;
+	bool whole = true, lineStart;
+	while(!stream->eof()) {
+		str = stream->readLine(line, 256);
+		if(str == NULL) break;
+		//a line too long for the buffer arrives in pieces - skip them all
+		lineStart = whole;
+		int len = strlen(str);
+		whole = len > 0 && str[len-1] == '\n';
+		if(!whole || !lineStart) continue;
+		ss.clear();
+		ss.str(str);
+		ss >> type >> id;
+		if(ss.fail()) continue;
+		MyNode *node = dynamic_cast<MyNode*>(_scene->findNode(id.c_str(), false));
+		if(type.compare("move") == 0) {
+			for(i = 0; i < 10; i++) ss >> f[i];
+			ss >> std::ws;
+			if(ss.fail() || !ss.eof() || node == NULL) continue;
+			node->enablePhysics(false);
+			node->setTranslation(f[0], f[1], f[2]);
+			Quaternion rotation(f[3], f[4], f[5], f[6]);
+			rotation.normalize();
+			node->setRotation(rotation);
+			node->setScale(f[7], f[8], f[9]);
+			node->enablePhysics();
+		} else if(type.compare("node") == 0) {
+			std::string nodeFile = getSceneDir() + id + ".node";
+			if(!FileSystem::fileExists(nodeFile.c_str())) {
+				GP_WARN("Journal names node %s but its file is missing", id.c_str());
+				continue;
+			}
+			if(node) removeNode(node);
+			loadNode(id.c_str());
+		} else if(type.compare("remove") == 0) {
+			if(node) removeNode(node);
+		} else continue;
+		_journalEntries++;
+	}
+}
+
 void T4TApp::clearScene() {
 	std::vector<MyNode*> nodes;
 	for(Node *n = _scene->getFirstNode(); n != NULL; n = n->getNextSibling()) {
@@ -1209,9 +1694,10 @@ void T4TApp::removeNode(MyNode *node, bool erase) {
 	_scene->removeNode(node);
 }
 
+//nodes that are not part of the scene's content - a mode's helper nodes can be in the scene mid-action
 bool T4TApp::auxNode(Node *node) {
 	const char *id = node->getId();
-	return strcmp(id, "grid") == 0 || strcmp(id, "axes") == 0 || strcmp(id, "camera") == 0;
+	return strcmp(id, "grid") == 0 || strcmp(id, "axes") == 0 || strcmp(id, "camera") == 0 || node->hasTag("helper");
 }
 
 void T4TApp::releaseScene()
@@ -1371,6 +1857,7 @@ void T4TApp::confirmDelete(bool yes) {
 }
 
 void T4TApp::message(const char *text, int locations) {
+	if(_headless) return;
 	std::vector<Label*> messages;
 	if(locations & MESSAGE_BOTTOM) messages.push_back(_messages[MESSAGE_BOTTOM]);
 	if(locations & MESSAGE_TOP) messages.push_back(_messages[MESSAGE_TOP]);
@@ -1388,6 +1875,7 @@ void T4TApp::message(const char *text, int locations) {
 }
 
 bool T4TApp::hasMessage(int locations) {
+	if(_headless) return false;
 	if(locations & MESSAGE_BOTTOM && _messages[MESSAGE_BOTTOM]->isVisible()) return true;
 	if(locations & MESSAGE_TOP && _messages[MESSAGE_TOP]->isVisible()) return true;
 	if(locations & MESSAGE_CENTER && _messages[MESSAGE_CENTER]->isVisible()) return true;
@@ -1423,38 +1911,305 @@ bool T4TApp::buildRenderQueues(Node* node)
     if (model)
     {
         // Determine which render queue to insert the node into
-        std::vector<Node*>* queue;
+        std::vector<RenderItem>* queue;
         if (node->hasTag("transparent"))
             queue = &_renderQueues[QUEUE_TRANSPARENT];
         else
             queue = &_renderQueues[QUEUE_OPAQUE];
 
-        queue->push_back(node);
+        RenderItem item;
+        item.node = node;
+        item.myNode = dynamic_cast<MyNode*>(node);
+        item.model = model;
+        item.material = model->getMaterial();
+        item.effect = NULL;
+        if(item.material && item.material->getTechnique() && item.material->getTechnique()->getPassCount() > 0)
+        	item.effect = item.material->getTechnique()->getPassByIndex(0)->getEffect();
+        //single pass, single material, solid and with a known color => can be drawn from another instance's render state
+        item.instanced = item.effect && item.myNode && item.myNode->_drawColor.x >= 0
+        	&& !item.myNode->_wireframe && !item.myNode->_chain
+        	&& item.material->getTechnique()->getPassCount() == 1 && model->getMesh()->getPartCount() <= 1
+        	&& instanceableEffect(item.effect);
+        node->addRef(); //so a node deleted between rebuilds is never drawn from a stale pointer
+        queue->push_back(item);
     }
     return true;
 }
 
+void T4TApp::clearRenderQueues()
+{
+	for(short i = 0; i < QUEUE_COUNT; i++) {
+		for(size_t j = 0; j < _renderQueues[i].size(); j++) _renderQueues[i][j].node->release();
+		_renderQueues[i].clear();
+	}
+	_renderRoots.clear();
+}
+
+//call when a node's drawable or render tags change
+void T4TApp::invalidateRenderQueues()
+{
+	_renderDirty = true;
+}
+
+//O(1) lookup of a node in the given scene (default: active scene) by ID
+MyNode* T4TApp::lookupNode(const std::string &id, Scene *scene)
+{
+	if(!scene) scene = _activeScene;
+	std::unordered_map<std::string, MyNode*>::iterator it = _nodeIndex.find(id);
+	if(it != _nodeIndex.end()) {
+		if(id.compare(it->second->getId()) == 0) {
+			if(it->second->getScene() == scene) return it->second;
+		} else {
+			//renamed behind the index's back - its new ID is not indexed either
+			_nodeIndex.erase(it);
+			_nodeIndexDirty = true;
+		}
+	}
+	//on a miss, reindex the scene if nodes have joined or left it since the last time - children that move flag the
+	//index themselves, and new top-level nodes show in the root list - otherwise the miss stands
+	bool rootsChanged = sceneRootsChanged(scene, _nodeIndexRoots);
+	if(!_nodeIndexDirty && !rootsChanged && scene == _nodeIndexScene) return NULL;
+	_nodeIndex.clear();
+	for(Node *n = scene->getFirstNode(); n; n = n->getNextSibling()) indexNodes(n);
+	_nodeIndexDirty = false;
+	_nodeIndexScene = scene;
+	it = _nodeIndex.find(id);
+	return it != _nodeIndex.end() ? it->second : NULL;
+}
+
+void T4TApp::indexNodes(Node *node)
+{
+	MyNode *myNode = dynamic_cast<MyNode*>(node);
+	if(myNode && myNode->getId()[0] != '\0') _nodeIndex.insert(std::make_pair(std::string(myNode->getId()), myNode));
+	for(Node *child = node->getFirstChild(); child; child = child->getNextSibling()) indexNodes(child);
+}
+
+//entries are always keyed by the node's current ID, so this finds any entry for it
+void T4TApp::unindexNode(MyNode *node)
+{
+	std::unordered_map<std::string, MyNode*>::iterator it = _nodeIndex.find(node->getId());
+	if(it != _nodeIndex.end() && it->second == node) _nodeIndex.erase(it);
+}
+
+void T4TApp::invalidateNodeIndex()
+{
+	_nodeIndexDirty = true;
+}
+
+//the tree is rebuilt when nodes join or leave the scene - otherwise only the nodes that have moved are refit
+SceneTree* T4TApp::getSceneTree()
+{
+	if(sceneRootsChanged(_scene, _sceneTreeRoots) || _sceneTreeDirty) {
+		_sceneTree.clear();
+		for(Node *node = _scene->getFirstNode(); node; node = node->getNextSibling()) addToSceneTree(node);
+		_sceneTreeDirty = false;
+	}
+	_sceneTree.refit();
+	return &_sceneTree;
+}
+
+void T4TApp::addToSceneTree(Node *node)
+{
+	MyNode *myNode = dynamic_cast<MyNode*>(node);
+	if(myNode) myNode->_treeLeaf = _sceneTree.insert(myNode);
+	for(Node *child = node->getFirstChild(); child; child = child->getNextSibling()) addToSceneTree(child);
+}
+
+//a deleted node's address may come back as a new node, so the tree is rebuilt rather than trusting its roots
+void T4TApp::removeFromSceneTree(MyNode *node)
+{
+	if(!_sceneTree.contains(node->_treeLeaf, node)) return;
+	_sceneTree.remove(node->_treeLeaf);
+	_sceneTreeDirty = true;
+}
+
+void T4TApp::invalidateSceneTree()
+{
+	_sceneTreeDirty = true;
+}
+
+//called on every transform change, so it only flags the node's leaf
+void T4TApp::nodeMoved(MyNode *node)
+{
+	if(_sceneTree.contains(node->_treeLeaf, node)) _sceneTree.touch(node->_treeLeaf);
+}
+
+//a moved node's world data and body are brought up to date before physics next runs and at the end of the frame,
+//however many times it moved in between
+void T4TApp::queueTransform(MyNode *node, bool body)
+{
+	node->_transformDirty = true;
+	if(body) node->_bodyDirty = true;
+	if(node->_moveQueued) return;
+	node->_moveQueued = true;
+	_movedNodes.push_back(node);
+}
+
+void T4TApp::dequeueTransform(MyNode *node)
+{
+	std::vector<MyNode*>::iterator it = std::find(_movedNodes.begin(), _movedNodes.end(), node);
+	if(it != _movedNodes.end()) _movedNodes.erase(it);
+	node->_moveQueued = false;
+}
+
+//one top-down pass redoes the world data of each moved subtree, skipping nodes under another moved node since they are
+//redone with it - then, with every world matrix final, the bodies that were moved are pushed to the physics world
+void T4TApp::flushTransforms()
+{
+	if(_movedNodes.empty()) return;
+	std::vector<MyNode*> roots;
+	size_t n = _movedNodes.size(), i;
+	for(i = 0; i < n; i++) {
+		MyNode *node = _movedNodes[i];
+		if(!node->_transformDirty) continue; //updated directly since it moved
+		bool covered = false;
+		for(Node *parent = node->getParent(); parent && !covered; parent = parent->getParent()) {
+			MyNode *myParent = dynamic_cast<MyNode*>(parent);
+			covered = myParent && myParent->_transformDirty;
+		}
+		if(!covered) roots.push_back(node);
+	}
+	for(i = 0; i < roots.size(); i++) roots[i]->updateTransform();
+	for(i = 0; i < n; i++) {
+		MyNode *node = _movedNodes[i];
+		if(node->_bodyDirty) {
+			PhysicsCollisionObject *obj = node->getCollisionObject();
+			PhysicsRigidBody *body = obj && obj->isEnabled() ? dynamic_cast<PhysicsRigidBody*>(obj) : NULL;
+			if(body) {
+				body->syncTransform();
+				body->setActivation(ACTIVE_TAG);
+			}
+		}
+		node->_bodyDirty = false;
+		node->_moveQueued = false;
+	}
+	_movedNodes.clear();
+}
+
+//child nodes flag their own reparenting - here we just watch for nodes added to or removed from the scene root
+bool T4TApp::sceneRootsChanged(Scene *scene, std::vector<Node*> &roots)
+{
+	bool changed = false;
+	size_t n = 0;
+	for(Node *node = scene->getFirstNode(); node; node = node->getNextSibling(), n++) {
+		if(!changed && (n >= roots.size() || roots[n] != node)) changed = true;
+	}
+	if(n != roots.size()) changed = true;
+	if(changed) {
+		roots.clear();
+		for(Node *node = scene->getFirstNode(); node; node = node->getNextSibling()) roots.push_back(node);
+	}
+	return changed;
+}
+
+bool T4TApp::renderQueuesChanged()
+{
+	bool changed = sceneRootsChanged(_activeScene, _renderRoots);
+	return changed || _renderDirty;
+}
+
 void T4TApp::drawScene()
 {
+	Camera *camera = _activeScene->getActiveCamera();
+	const Frustum *frustum = camera ? &camera->getFrustum() : NULL;
     // Iterate through each render queue and draw the nodes in them
     for (unsigned int i = 0; i < QUEUE_COUNT; ++i)
     {
-        std::vector<Node*>& queue = _renderQueues[i];
+        std::vector<RenderItem>& queue = _renderQueues[i];
+        _visibleItems.clear();
 
         for (size_t j = 0, ncount = queue.size(); j < ncount; ++j)
         {
-            drawNode(queue[j]);
+        	RenderItem &item = queue[j];
+        	if(item.node->getDrawable() != item.model) { //model was swapped out - pick it up on the next rebuild
+        		_renderDirty = true;
+        		continue;
+        	}
+        	if(item.myNode && !item.myNode->_visible) continue;
+        	//skip nodes removed from the scene since the queues were built
+        	if(item.node->getScene() != _activeScene) continue;
+        	//cull against the model's bounding sphere in world space
+        	if(frustum) {
+        		BoundingSphere sphere = item.model->getMesh()->getBoundingSphere();
+        		if(sphere.radius > 0) {
+	        		sphere.transform(item.node->getWorldMatrix());
+	        		if(!frustum->intersects(sphere)) continue;
+	        	}
+        	}
+            _visibleItems.push_back(item);
+        }
+        //runs of opaque nodes sharing a mesh and shader are drawn with one render state bind
+        size_t start = 0, end, n = _visibleItems.size();
+        while(start < n) {
+        	end = start + 1;
+        	if(i == QUEUE_OPAQUE && _visibleItems[start].instanced) {
+        		Mesh *mesh = _visibleItems[start].model->getMesh();
+        		while(end < n && _visibleItems[end].instanced && _visibleItems[end].effect == _visibleItems[start].effect
+        		  && _visibleItems[end].model->getMesh() == mesh
+        		  && _visibleItems[end].myNode->_lightNode == _visibleItems[start].myNode->_lightNode) end++;
+        	}
+        	if(end - start > 1) drawInstances(_visibleItems, start, end);
+        	else drawNode(_visibleItems[start]);
+        	start = end;
         }
     }
 }
 
-bool T4TApp::drawNode(Node* node)
+//bind the first node's pass, then for each node set only the uniforms that differ per instance and issue its draw
+//whether every uniform of the effect is either reset per node by drawInstances or the same for every node using it -
+//the light's, bound to the scene's one light node, and u_diffuseColor, which keeps its material value since nothing
+//sets it per node; any other uniform, eg. a world or view matrix or the camera position, could differ between nodes
+bool T4TApp::instanceableEffect(Effect *effect)
 {
-	Drawable *drawable = node->getDrawable();
+	static const char *shared[] = {"u_worldViewProjectionMatrix", "u_inverseTransposeWorldViewMatrix", "u_ambientColor",
+		"u_modulateAlpha", "u_directionalLightColor[0]", "u_directionalLightDirection[0]", "u_diffuseColor"};
+	unsigned int n = effect->getUniformCount(), i;
+	short j, numShared = sizeof(shared) / sizeof(shared[0]);
+	for(i = 0; i < n; i++) {
+		const char *name = effect->getUniform(i)->getName();
+		for(j = 0; j < numShared && strcmp(name, shared[j]) != 0; j++);
+		if(j == numShared) return false;
+	}
+	return true;
+}
+
+void T4TApp::drawInstances(std::vector<RenderItem> &items, size_t start, size_t end)
+{
+	Pass *pass = items[start].material->getTechnique()->getPassByIndex(0);
+	Effect *effect = pass->getEffect();
+	Uniform *wvp = effect->getUniform("u_worldViewProjectionMatrix"),
+		*itwv = effect->getUniform("u_inverseTransposeWorldViewMatrix"),
+		*ambient = effect->getUniform("u_ambientColor"),
+		*alpha = effect->getUniform("u_modulateAlpha");
+	Mesh *mesh = items[start].model->getMesh();
+	MeshPart *part = mesh->getPartCount() > 0 ? mesh->getPart(0) : NULL;
+	pass->bind();
+	if(part) GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->getIndexBuffer()) );
+	for(size_t i = start; i < end; i++) {
+		Node *node = items[i].node;
+		const Vector4 &color = items[i].myNode->_drawColor;
+		if(i > start) {
+			if(wvp) effect->setValue(wvp, node->getWorldViewProjectionMatrix());
+			if(itwv) effect->setValue(itwv, node->getInverseTransposeWorldViewMatrix());
+		}
+		if(ambient) effect->setValue(ambient, Vector3(color.x, color.y, color.z));
+		if(alpha) effect->setValue(alpha, color.w);
+		if(part) {
+			GL_ASSERT( glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0) );
+		} else {
+			GL_ASSERT( glDrawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount()) );
+		}
+	}
+	pass->unbind();
+}
+
+bool T4TApp::drawNode(const RenderItem &item)
+{
+	Drawable *drawable = item.model;
 	if(!drawable) return true;
 	bool wireframe = false;
 	float lineWidth = 1.0f;
-	MyNode *myNode = dynamic_cast<MyNode*>(node);
+	MyNode *myNode = item.myNode;
 	if(myNode) {
 		if(!myNode->_visible) return true;
 		wireframe = myNode->_wireframe || myNode->_chain;
@@ -1466,15 +2221,28 @@ bool T4TApp::drawNode(Node* node)
     return true;
 }
 
-MyNode* T4TApp::getMouseNode(int x, int y, Vector3 *touch) {
-	Camera* camera = _scene->getActiveCamera();
-	Ray ray;
-	camera->pickRay(getViewport(), x, y, &ray);
-	PhysicsController::HitResult hitResult;
-	if(!getPhysicsController()->rayTest(ray, camera->getFarPlane(), &hitResult)) return NULL;
-	if(touch) touch->set(hitResult.point);
-	MyNode *node = dynamic_cast<MyNode*>(hitResult.object->getNode());
-	if(!node || strcmp(node->getId(), "grid") == 0) return NULL;
+//nearest node the ray hits - in the main scene, the surfaces of the nodes whose boxes the ray meets are tested, so
+//nodes with their physics switched off or removed can be picked too; helper nodes like the tool and its ghost are not
+MyNode* T4TApp::pickNode(const Ray &ray, float distance, Vector3 *point, Vector3 *normal) {
+	if(_activeScene != _scene) {
+		PhysicsController::HitResult result;
+		if(!getPhysicsController()->rayTest(ray, distance, &result, _hitFilter)) return NULL;
+		if(point) *point = result.point;
+		if(normal) *normal = result.normal;
+		return dynamic_cast<MyNode*>(result.object->getNode());
+	}
+	std::vector<MyNode*> nodes;
+	getSceneTree()->queryRay(ray, distance, nodes);
+	MyNode *node = NULL;
+	Vector3 p, n;
+	float d;
+	for(short i = 0; i < nodes.size(); i++) {
+		if(auxNode(nodes[i]) || !nodes[i]->rayTest(ray, &d, &p, &n) || d >= distance) continue;
+		node = nodes[i];
+		distance = d;
+		if(point) *point = p;
+		if(normal) *normal = n;
+	}
 	return node;
 }
 
@@ -1488,19 +2256,19 @@ bool T4TApp::checkTouchModel(Node* n)
 	if(strcmp(node->getId(), "drill") == 0) return true;
 	for(int i = 0; i < _intersectNodeGroup.size(); i++)
 		if(node == _intersectNodeGroup[i]) return true;
-	Vector3 pos = node->getTranslation();
-	BoundingBox bbox = node->getBoundingBox();
-	if(bbox.isEmpty()) return true;
+	//my own box only - my children are checked in their own right
+	if(node->_worldVertices.empty()) return true;
+	BoundingBox bbox = node->getBoundingBox(false, false);
 	float halfX = (_intersectBox.max.x - _intersectBox.min.x) / 2.0f,
 		halfY = (_intersectBox.max.y - _intersectBox.min.y) / 2.0f,
 		halfZ = (_intersectBox.max.z - _intersectBox.min.z) / 2.0f;
-	if(_intersectPoint.x + halfX > pos.x + bbox.min.x && _intersectPoint.x - halfX < pos.x + bbox.max.x
-		&& _intersectPoint.z + halfZ > pos.z + bbox.min.z && _intersectPoint.z - halfZ < pos.z + bbox.max.z)
+	if(_intersectPoint.x + halfX > bbox.min.x && _intersectPoint.x - halfX < bbox.max.x
+		&& _intersectPoint.z + halfZ > bbox.min.z && _intersectPoint.z - halfZ < bbox.max.z)
 	{
-		if(_intersectModel == NULL || halfY + pos.y + bbox.max.y > _intersectPoint.y)
+		if(_intersectModel == NULL || halfY + bbox.max.y > _intersectPoint.y)
 		{
 			_intersectModel = node;
-			_intersectPoint.y = pos.y + bbox.max.y + halfY;
+			_intersectPoint.y = bbox.max.y + halfY;
 		}
 	}
 	return true;
@@ -1511,7 +2279,6 @@ MyNode* T4TApp::duplicateModelNode(const char* type, bool isStatic)
 	MyNode *modelNode = dynamic_cast<MyNode*>(_models->findNode(type));
 	if(!modelNode) return NULL;
 	MyNode *node = MyNode::cloneNode(modelNode);
-	BoundingBox box = node->getModel()->getMesh()->getBoundingBox();
 	std::ostringstream os;
 	os << modelNode->getId() << ++modelNode->_typeCount;
 	node->setId(os.str().c_str());
@@ -1530,7 +2297,9 @@ MyNode* T4TApp::addModelNode(const char *type) {
 	return node;
 }
 
-Model* T4TApp::createModel(std::vector<float> &vertices, bool wireframe, const char *material, Node *node, bool doTexture) {
+Model* T4TApp::createModel(std::vector<float> &vertices, bool wireframe, const char *material, Node *node, bool doTexture,
+  std::vector<unsigned short> *indices) {
+	if(_headless) return NULL; //no GL context to hold the buffers
 	int numVertices = vertices.size() / (doTexture ? 8 : 6);
 	VertexFormat::Element elements[3];
 	elements[0] = VertexFormat::Element(VertexFormat::POSITION, 3);
@@ -1539,19 +2308,37 @@ Model* T4TApp::createModel(std::vector<float> &vertices, bool wireframe, const c
 	Mesh* mesh = Mesh::createMesh(VertexFormat(elements, doTexture ? 3 : 2), numVertices, false);
 	mesh->setPrimitiveType(wireframe ? Mesh::LINES : Mesh::TRIANGLES);
 	mesh->setVertexData(&vertices[0], 0, numVertices);
+	if(indices && !indices->empty()) {
+		MeshPart *part = mesh->addPart(wireframe ? Mesh::LINES : Mesh::TRIANGLES, Mesh::INDEX16, indices->size(), false);
+		part->setIndexData(&(*indices)[0], 0, indices->size());
+	}
 	Model *model = Model::create(mesh);
 	mesh->release();
-	Material *mat = Material::create(MyNode::concat(2, "res/common/models.material#", material));
-	if(!mat) mat = Material::create("res/common/models.material#colored");
+	Material *mat = createMaterial(material);
+	if(!mat) mat = createMaterial("colored");
 	model->setMaterial(mat);
+	SAFE_RELEASE(mat);
 	if(node) {
 		if(node->getDrawable()) node->setDrawable(NULL);
 		node->setDrawable(model);
 		model->release();
+		invalidateRenderQueues();
 	}
 	return model;
 }
 
+//build a material from the cached material file - effects are shared by the engine's effect cache
+Material* T4TApp::createMaterial(const char *name) {
+	if(_materialProps == NULL) {
+		_materialProps = Properties::create("res/common/models.material");
+		if(_materialProps == NULL) return NULL;
+	}
+	Properties *props = _materialProps->getNamespace(name);
+	if(props == NULL) return NULL;
+	props->rewind();
+	return Material::create(props);
+}
+
 MyNode* T4TApp::createWireframe(std::vector<float>& vertices, const char *id) {
 	if(id == NULL) id = "wireframe1";
 	MyNode *node = MyNode::create(id);
@@ -1581,7 +2368,14 @@ void T4TApp::placeNode(MyNode *node, float x, float z)
 	node->setTranslation(x, -minY, z); //put the bounding box bottom on the ground
 	_intersectPoint.set(x, -minY, z);
 	_intersectModel = NULL;
-	_scene->visit(this, &T4TApp::checkTouchModel); //will change _intersectPoint.y to be above any intersecting models
+	//only nodes reaching over the footprint can hold it up
+	float halfX = (_intersectBox.max.x - _intersectBox.min.x) / 2.0f,
+		halfZ = (_intersectBox.max.z - _intersectBox.min.z) / 2.0f;
+	BoundingBox footprint(x - halfX, -1e6f, z - halfZ, x + halfX, 1e6f, z + halfZ);
+	std::vector<MyNode*> nodes;
+	getSceneTree()->queryBox(footprint, nodes);
+	//will change _intersectPoint.y to be above any intersecting models
+	for(short i = 0; i < nodes.size(); i++) checkTouchModel(nodes[i]);
 	node->setTranslation(_intersectPoint);
 }
 
@@ -1658,6 +2452,7 @@ void T4TApp::showEye(float radius, float theta, float phi) {
 void T4TApp::setActiveScene(Scene *scene)
 {
 	if(scene == _activeScene) return;
+	invalidateRenderQueues();
 	if(_activeScene != NULL) {
 		_activeScene->removeNode(_face);
 		_activeScene->visit(this, &T4TApp::hideNode);
@@ -2010,6 +2805,7 @@ PhysicsConstraint* T4TApp::addConstraint(MyNode *n1, MyNode *n2, int id, const c
 			constraint = node[i]->_constraints[j].get();
 		}
 		constraint->other = node[(i+1)%2]->getId();
+		constraint->node = node[(i+1)%2];
 		constraint->type = type;
 		constraint->rotation = rot[i];
 		constraint->translation = trans[i];
@@ -2038,7 +2834,7 @@ void T4TApp::addConstraints(MyNode *node) {
 	for(i = 0; i < node->_constraints.size(); i++) {
 		c1 = node->_constraints[i].get();
 		if(c1->id >= 0) continue;
-		MyNode *other = dynamic_cast<MyNode*>(_activeScene->findNode(c1->other.c_str()));
+		MyNode *other = node->getConstraintNode(c1, _activeScene);
 		if(!other || !other->getCollisionObject()) continue;
 		for(j = 0; j < other->_constraints.size(); j++) {
 			c2 = other->_constraints[j].get();
@@ -2059,7 +2855,7 @@ void T4TApp::removeConstraints(MyNode *node, MyNode *otherNode, bool erase) {
 	for(i = 0; i < node->_constraints.size(); i++) {
 		c1 = node->_constraints[i].get();
 		if(c1->id < 0) continue;
-		MyNode *other = dynamic_cast<MyNode*>(_activeScene->findNode(c1->other.c_str()));
+		MyNode *other = node->getConstraintNode(c1, _activeScene);
 		if(!other || (otherNode && other != otherNode)) continue;
 		for(j = 0; j < other->_constraints.size(); j++) {
 			c2 = other->_constraints[j].get();
@@ -2096,7 +2892,7 @@ void T4TApp::reloadConstraint(MyNode *node, nodeConstraint *constraint) {
 	if(id >= 0 && _constraints.find(id) != _constraints.end()) {
 		_constraints.erase(id);
 	}
-	MyNode *other = dynamic_cast<MyNode*>(_activeScene->findNode(constraint->other.c_str()));
+	MyNode *other = node->getConstraintNode(constraint, _activeScene);
 	if(!other) return;
 	nodeConstraint *otherConstraint;
 	for(short i = 0; i < other->_constraints.size(); i++) {
@@ -2133,6 +2929,19 @@ bool T4TApp::NodeFilter::filter(PhysicsCollisionObject *object) {
 }
 
 
+T4TApp::TransformFlusher::TransformFlusher(T4TApp *app_) : app(app_) {}
+
+//moves made since the last frame, eg. by touch and control handlers or undo
+void T4TApp::TransformFlusher::physicsUpdate() {
+	app->flushTransforms();
+}
+
+//moves made by tick listeners during the previous step
+void T4TApp::TransformFlusher::physicsTick(float timeStep) {
+	app->flushTransforms();
+}
+
+
 //BUTTON GROUPS
 std::vector<ButtonGroup*> ButtonGroup::_groups;
 std::map<Control*, ButtonGroup*> ButtonGroup::_index;
@@ -2406,6 +3215,12 @@ void AppForm::submit() {
 }
 
 
+T4TApp::Action::Action() : bytes(0) {}
+
+T4TApp::Action::~Action() {
+	for(short i = 0; i < refNodes.size(); i++) SAFE_RELEASE(refNodes[i]);
+}
+
 void T4TApp::setAction(const char *type, ...) {
 
 	va_list args;
@@ -2430,16 +3245,18 @@ void T4TApp::setAction(const char *type, ...) {
 	} else if(strcmp(type, "position") == 0) {
 		ref->set(node);
 	} else if(strcmp(type, "constraint") == 0) {
-		nodeConstraint *constraint = new nodeConstraint();
-		constraint->id = _constraintCount;
 		for(i = 0; i < 2; i++) {
+			//each reference owns its record, since the reference nodes are freed with the action
+			nodeConstraint *constraint = new nodeConstraint();
+			constraint->id = _constraintCount;
 			node = action->nodes[i];
 			ref = action->refNodes[i];
 			ref->set(node);
 			ref->_constraints.push_back(std::unique_ptr<nodeConstraint>(constraint));
 		}
 	} else if(strcmp(type, "tool") == 0) {
-		ref->copyMesh(node);
+		//the node's mesh moves into the reference as it is, so the caller must then give the node its new one
+		ref->swapMesh(node);
 	} else if(strcmp(type, "test") == 0) {
 		ref->set(node);
 	}
@@ -2448,9 +3265,13 @@ void T4TApp::setAction(const char *type, ...) {
 
 void T4TApp::commitAction() {
 	if(_action == NULL) return;
-	delAll(_undone); //can't redo anything once something else is done
+	//can't redo anything once something else is done
+	while(!_undone.empty()) discardAction(popBack(_undone), true);
 	_history.push_back(_action);
+	countAction(_action);
+	journalAction(_action);
 	_action = NULL;
+	trimHistory();
 	if(_undo) _undo->setEnabled(true);
 	if(_redo) _redo->setEnabled(false);
 }
@@ -2489,6 +3310,7 @@ void T4TApp::undoLastAction() {
 					ref = action->refNodes[i];
 					ref->_constraints.push_back(std::move(node->_constraints.back()));
 					node->_constraints.pop_back();
+					ref->_constraints.back()->node = NULL; //only live constraints hold node handles
 					if(i == 1) {
 						_scene->addNode(node); //also removes it from its constraint parent
 						node->_constraintParent = NULL;
@@ -2504,9 +3326,11 @@ void T4TApp::undoLastAction() {
 		removeNode(node);
 	}
 	if(allowRedo) {
+		journalAction(action);
+		countAction(action);
 		_undone.push_back(action);
 		if(_redo) _redo->setEnabled(true);
-	}
+	} else discardAction(action, false);
 	if(_undo && _history.empty()) _undo->setEnabled(false);
 }
 
@@ -2553,11 +3377,57 @@ void T4TApp::redoLastAction() {
 	} else if(strcmp(type, "test") == 0) {
 		action->nodes[0] = dropBall(ref->getTranslationWorld());
 	}
+	journalAction(action);
+	countAction(action);
 	_history.push_back(action);
 	if(_undo) _undo->setEnabled(true);
 	if(_redo && _undone.empty()) _redo->setEnabled(false);
 }
 
+//recount what an action holds, eg. after undo/redo has swapped a different mesh into its reference node
+void T4TApp::countAction(Action *action) {
+	_historyBytes -= action->bytes;
+	action->bytes = sizeof(Action);
+	short i;
+	for(i = 0; i < action->refNodes.size(); i++) action->bytes += action->refNodes[i]->getMemorySize();
+	//a deleted node, or an added one that was undone, is only being kept alive by the history
+	if(action->type.compare("addNode") == 0 || action->type.compare("deleteNode") == 0) {
+		MyNode *node = action->nodes[0];
+		if(node->getScene() == NULL) action->bytes += node->getMemorySize();
+	}
+	_historyBytes += action->bytes;
+}
+
+//free an action that can no longer be undone, or redone if it is in the undone list
+void T4TApp::discardAction(Action *action, bool undone) {
+	_historyBytes -= action->bytes;
+	if(action->type.compare(undone ? "addNode" : "deleteNode") == 0) action->nodes[0]->release();
+	delete action;
+}
+
+//keep the history within its memory budget - first fold runs of moves of the same node into one step, then drop
+//the oldest actions, always leaving the latest one undoable
+void T4TApp::trimHistory() {
+	short i = 0;
+	while(_historyBytes > _historyBudget && i+1 < _history.size()) {
+		Action *a1 = _history[i], *a2 = _history[i+1];
+		if(a1->type.compare("position") == 0 && a2->type.compare("position") == 0 && a1->nodes[0] == a2->nodes[0]) {
+			//the first one's reference already has where the node was before both moves
+			_history.erase(_history.begin() + i+1);
+			discardAction(a2, false);
+		} else i++;
+	}
+	while(_historyBytes > _historyBudget && _history.size() > 1) {
+		Action *action = _history.front();
+		_history.erase(_history.begin());
+		discardAction(action, false);
+	}
+}
+
+size_t T4TApp::getHistoryBytes() {
+	return _historyBytes;
+}
+
 void T4TApp::swapTransform(MyNode *n1, MyNode *n2) {
 	_tmpNode->set(n1);
 	n1->set(n2);
@@ -2565,9 +3435,7 @@ void T4TApp::swapTransform(MyNode *n1, MyNode *n2) {
 }
 
 void T4TApp::swapMesh(MyNode *n1, MyNode *n2) {
-	_tmpNode->copyMesh(n1);
-	n1->copyMesh(n2);
-	n2->copyMesh(_tmpNode);
+	n1->swapMesh(n2);
 }
 
 
@@ -9,6 +9,12 @@
 
 #define READ_BUF_SIZE 8192
 
+//build with T4T_HEADLESS defined for a physics-only runtime: loads a scene, steps it at a fixed rate and exits.
+//Define it on the command line together with GP_NO_PLATFORM, for the engine and the game alike, so that
+//gameplay_src/PlatformHeadless.cpp replaces the windowed platform and no window or GL context is ever made.
+//Projects are built without their menus and nodes without GL models, so launches run as they do in the app.
+//#define T4T_HEADLESS
+
 #include <cmath>
 #include <cstring>
 #include <sstream>
@@ -17,6 +23,7 @@
 #include <cstdlib>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <limits>
 #include <algorithm>
 #include <memory>
@@ -24,6 +31,7 @@
 	#include "pugixml.hpp"
 #endif
 #include "gameplay.h"
+#include "SceneTree.h"
 
 using std::cout;
 using std::endl;
@@ -87,6 +95,7 @@ class TouchPoint {
 struct nodeConstraint {
 	int id; //global ID in simulation for this constraint
 	std::string other; //id of the node to which this one is constrained
+	MyNode *node; //that node itself - set on both sides by addConstraint and cleared when either node is destroyed
 	std::string type; //one of: hinge, spring, fixed, socket
 	Vector3 translation; //offset of the constraint point from my origin
 	Quaternion rotation; //rotation offset of the constraint point
@@ -94,6 +103,21 @@ struct nodeConstraint {
 	bool noCollide; //ignore collisions between the two constrained nodes
 };
 
+//physics state of a node tree at one moment - restoring it moves bodies back in place without rebuilding them
+struct PhysicsSnapshot {
+	struct BodyState {
+		MyNode *node;
+		Vector3 scale, translation;
+		Quaternion rotation;
+		Vector3 linearVelocity, angularVelocity;
+		int activation; //-1 if the node has no rigid body
+	};
+	std::vector<BodyState> bodies; //parents before children
+	std::vector<std::pair<int, bool> > constraints; //constraint ID and whether it was enabled
+	bool empty() const { return bodies.empty(); }
+	void clear() { bodies.clear(); constraints.clear(); }
+};
+
 class ButtonGroup {
 public:
 	T4TApp *app;
@@ -176,7 +200,30 @@ public:
     Scene* _scene;
     Node* _lightNode;
     Light* _light;
-    std::vector<Node*> _renderQueues[2];
+    struct RenderItem {
+    	Node *node;
+    	MyNode *myNode; //NULL if not a MyNode
+    	Model *model;
+    	Effect *effect; //for sorting draws by render state
+    	Material *material;
+    	bool instanced; //can share one render state bind with other nodes using the same mesh
+    };
+    std::vector<RenderItem> _visibleItems;
+    std::vector<RenderItem> _renderQueues[2]; //persistent - only rebuilt when the scene structure changes
+    std::vector<Node*> _renderRoots; //top-level nodes of the active scene when the queues were built
+    bool _renderDirty;
+    Properties *_materialProps; //models.material, parsed once and shared by every model
+    bool _headless; //no UI, models or rendering - see T4T_HEADLESS
+    Mesh *_physicsMesh; //stands in for node models when building mesh collision shapes headless
+    std::map<std::string, std::string> _batchDesigns; //project => directory of the design it loaded for a batch job
+    //outcome of one launch in a headless batch run - see runBatch
+    struct LaunchResult {
+    	std::string name;
+    	float distance; //how far the centroid of the payload's dynamic bodies (or the project's, or for a scene, any tree's) moved in the ground plane
+    	bool broken; //a constraint broke during the run
+    	bool success; //passed the project's own test - intact, and over the finish line if it has one
+    	double wallTime; //ms
+    };
     
 	//the functionality of the various interactive modes    
 	std::vector<Mode*> _modes;
@@ -196,8 +243,18 @@ public:
     Plane _groundPlane;
     
     //each constraint in the simulation will have an integer ID for lookup
-    std::map<int, ConstraintPtr> _constraints;
+    std::unordered_map<int, ConstraintPtr> _constraints;
     int _constraintCount;
+    //scene nodes by ID - checked on use, and rebuilt on a miss once nodes have joined, left or been renamed
+    std::unordered_map<std::string, MyNode*> _nodeIndex;
+    bool _nodeIndexDirty;
+    Scene *_nodeIndexScene; //the scene the index covers
+    std::vector<Node*> _nodeIndexRoots; //top-level nodes of that scene when it was indexed
+    //scene nodes by box, for placement and picking whether or not their physics is on - see getSceneTree
+    SceneTree _sceneTree;
+    std::vector<Node*> _sceneTreeRoots; //top-level nodes of the scene when the tree was built
+    bool _sceneTreeDirty;
+    std::vector<MyNode*> _movedNodes; //moved since the last frame - see flushTransforms
     
     //current state
     bool _hasInternet;
@@ -221,9 +278,16 @@ public:
     	std::string type;
     	//the node(s) that were acted upon and a reference for each one, holding any info needed to revert the action
     	std::vector<MyNode*> nodes, refNodes;
+    	size_t bytes; //memory held by the reference nodes, as last counted
+    	Action();
+    	~Action();
     };
     Action *_action; //the current, uncommitted action
     std::vector<Action*> _history, _undone; //queue of committed actions and those undone since the last commit
+    size_t _historyBytes, _historyBudget; //memory held by the committed actions, and the most they may hold
+    //crash recovery - each action, undo and redo appends what it left its nodes like to the scene's journal,
+    //which is folded back into the full scene files every so many entries
+    int _journalEntries, _journalCompact;
     MyNode *_tmpNode; //for swapping info between nodes
     int _tmpCount; //number of nodes whose info has been temporarily saved to disk
     
@@ -299,7 +363,8 @@ public:
     MyNode* duplicateModelNode(const char* type, bool isStatic = false);
     MyNode* addModelNode(const char *type);
     Model* createModel(std::vector<float> &vertices, bool wireframe = false, const char *material = "colored",
-    	Node *node = NULL, bool doTexture = false);
+    	Node *node = NULL, bool doTexture = false, std::vector<unsigned short> *indices = NULL);
+    Material* createMaterial(const char *name);
     MyNode* createWireframe(std::vector<float>& vertices, const char *id=NULL);
 	MyNode* dropBall(Vector3 point);
 	void showFace(Meshy *mesh, std::vector<unsigned short> &face, bool world = false);
@@ -328,6 +393,10 @@ public:
 	bool auxNode(Node *node);
 	void saveScene(const char *scene = NULL);
 	bool saveNode(Node *n);
+	std::string getJournalFile();
+	void journalAction(Action *action);
+	void writeJournal(const std::string &entry);
+	void replayJournal();
 	void releaseScene();
 	bool hideNode(Node *node);
 	void showScene();
@@ -361,6 +430,10 @@ public:
     void commitAction();
     void undoLastAction();
     void redoLastAction();
+    void countAction(Action *action);
+    void discardAction(Action *action, bool undone);
+    void trimHistory();
+    size_t getHistoryBytes();
     void swapTransform(MyNode *n1, MyNode *n2);
     void swapMesh(MyNode *n1, MyNode *n2);
 
@@ -391,6 +464,12 @@ public:
     void enableListener(bool enable, Control *control, Control::Listener *listener, int evtFlags = Control::Listener::CLICK);
 
     void initialize();
+    void initHeadless();
+    void initTimeStep();
+    void simulate(float duration, float timeStep);
+    bool loadBatchDesign(Project *project, std::string dir);
+    LaunchResult evaluateLaunch(Properties *job, float duration, float timeStep);
+    void runBatch(Properties *batch, float duration, float timeStep);
     void drawSplash(void *param);
     void splash(const char *msg);
     void finalize();
@@ -398,7 +477,25 @@ public:
     void render(float elapsedTime);
     void redraw();
     bool buildRenderQueues(Node *node);
-    bool drawNode(Node* node);
+    void clearRenderQueues();
+    void invalidateRenderQueues();
+    MyNode* lookupNode(const std::string &id, Scene *scene = NULL);
+    void indexNodes(Node *node);
+    void unindexNode(MyNode *node);
+    void invalidateNodeIndex();
+    SceneTree* getSceneTree();
+    void addToSceneTree(Node *node);
+    void removeFromSceneTree(MyNode *node);
+    void invalidateSceneTree();
+    void nodeMoved(MyNode *node);
+    void queueTransform(MyNode *node, bool body = false);
+    void dequeueTransform(MyNode *node);
+    void flushTransforms();
+    bool sceneRootsChanged(Scene *scene, std::vector<Node*> &roots);
+    bool renderQueuesChanged();
+    bool drawNode(const RenderItem &item);
+    bool instanceableEffect(Effect *effect);
+    void drawInstances(std::vector<RenderItem> &items, size_t start, size_t end);
     void drawScene();
     void placeNode(MyNode *node, float x, float y);
     void setMode(short mode);
@@ -408,7 +505,7 @@ public:
 
     //see if the current touch coordinates intersect a given model in the scene
     bool checkTouchModel(Node* node);
-    MyNode* getMouseNode(int x, int y, Vector3 *touch = NULL);
+    MyNode* pickNode(const Ray &ray, float distance, Vector3 *point = NULL, Vector3 *normal = NULL);
     
     //UI factory functions
     Form* addMenu(const char *name, Container *parent = NULL, const char *buttonText = NULL,
@@ -465,6 +562,17 @@ public:
 		bool filter(PhysicsCollisionObject *object);
 	};
 	NodeFilter *_nodeFilter;
+
+	//brings moved nodes' bodies up to date before physics runs, so a step never starts from a stale pose and a body's
+	//motion state never writes an old pose back over a node that was just set
+	class TransformFlusher : public PhysicsController::TickListener {
+		public:
+		T4TApp *app;
+		TransformFlusher(T4TApp *app_);
+		void physicsUpdate();
+		void physicsTick(float timeStep);
+	};
+	TransformFlusher *_transformFlusher;
 };
 
 }
@@ -68,6 +68,10 @@ Nef nodeToNef(MyNode *node) {
 }
 
 bool ToolMode::drillCGAL() {
+	if(!_newNode) {
+		_newNode = MyNode::create("newNode_tool");
+		_newNode->setTag("helper");
+	}
 	_tool->updateTransform();
 	//convert the node and tool meshes to Nef polyhedra
 	Polyhedron nodePoly, toolPoly;
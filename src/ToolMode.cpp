@@ -13,7 +13,11 @@ ToolMode::ToolMode()
 	usageCount = 0;
 
 	_tool = MyNode::create("tool_tool");
-	_newNode = MyNode::create("newNode_tool");
+	_newNode = NULL;
+	_ghost = MyNode::create("ghost_tool");
+	_tool->setTag("helper");
+	_ghost->setTag("helper");
+	_previewQuit = false;
 	
 	_moveMenu = (Container*)_controls->getControl("moveMenu");
 	setMoveMode(-1);
@@ -151,6 +155,18 @@ void ToolMode::setTool(short n) {
 	_tool->_vertices = tool->_vertices;
 	_tool->_faces = tool->_faces;
 	_tool->updateAll();
+	requestPreview();
+}
+
+ToolMode::~ToolMode() {
+	stopPreview();
+	if(_previewThread.joinable()) {
+		_previewMutex.lock();
+		_previewQuit = true;
+		_previewMutex.unlock();
+		_previewWake.notify_all();
+		_previewThread.join();
+	}
 }
 
 ToolMode::Tool* ToolMode::getTool() {
@@ -168,10 +184,13 @@ bool ToolMode::setSelectedNode(MyNode *node, Vector3 point) {
 	if(node != NULL) {
 		_toolTrans.set(0, 0);
 		_toolRot = 0;
+		_cutSource.reset();
 		placeTool();
 		_scene->addNode(_tool);
 		//app->showFace(_selectedNode, _selectedNode->_faces[3], true);
 	} else {
+		stopPreview();
+		_cutSource.reset();
 		_scene->removeNode(_tool);
 		_plane = app->_groundPlane;
 		setMoveMode(-1);
@@ -213,6 +232,7 @@ void ToolMode::placeTool() {
 	//view plane is orthogonal to the viewing axis and passing through the target node
 	_plane.setNormal(node - cam->getTranslationWorld());
 	_plane.setDistance(-_plane.getNormal().dot(node));
+	requestPreview();
 }
 
 bool ToolMode::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex) {
@@ -281,826 +301,313 @@ void ToolMode::controlEvent(Control *control, Control::Listener::EventType evt)
 	}
 }
 
-void ToolMode::setMesh(Meshy *mesh) {
-	_mesh = mesh;
-	short nv = _mesh->nv(), nf = _mesh->nf(), i, j, k;
-	keep.resize(nv);
-	toolVertices.resize(nv);
-	toolPlanes.resize(nf);
-	
-	for(i = 0; i < nv; i++) {
-		_toolInv.transformPoint(_mesh->_worldVertices[i], &toolVertices[i]);
-	}
-	for(i = 0; i < nf; i++) {
-		toolPlanes[i] = _mesh->_faces[i].getPlane();
-		toolPlanes[i].transform(_toolInv);
-	}
-}
-
 bool ToolMode::toolNode() {
 	if(_selectedNode == NULL) return false;
 	
-	_toolWorld = _tool->getWorldMatrix();
-	_toolWorld.invert(&_toolInv);
-	_toolNorm = _tool->getInverseTransposeWorldMatrix();
-	
-	_node = _selectedNode;
-	_node->updateTransform();
-	setMesh(_node);
-	_newMesh = _newNode;
-	_newNode->set(_node->getWorldMatrix()); //align the transforms
-	_faceNum = -1;
-	_hullNum = -1;
-	_hullSlice = -1;
-
-	//reset the data on the altered node
-	_newNode->_vertices.clear();
-	_newNode->_faces.clear();
-	_newNode->_edges.clear();
-	_newNode->_edgeInd.clear();
-	for(std::vector<MyNode::ConvexHull*>::iterator it= _newNode->_hulls.begin(); it != _newNode->_hulls.end(); it++) delete *it;
-	_newNode->_hulls.clear();
-	_newNode->_objType = "mesh";
-
-	short i, j, k;	
-	usageCount++;
+	//the preview worker is already cutting the tool's current pose, so let it finish rather than start over
+	std::unique_lock<std::mutex> lock(_previewMutex);
+	while(_previewRequest || _previewRunning) _previewWake.wait(lock);
+	std::shared_ptr<CutJob> preview = _preview;
+	lock.unlock();
+	stopPreview();
 	
-	edgeInt.clear();
-	toolInt.clear();
-	segmentEdges.clear();
+	_toolWorld = _tool->getWorldMatrix();
 	
-	Vector3 center = Vector3::zero();
-	axis = Vector3::unitZ();
-	right = -Vector3::unitX();
-	up = Vector3::unitY();
-	_axis.set(center - axis * 50, axis);
-
-	bool success = false;
-	switch(getTool()->type) {
-		case 0:
-			success = sawNode();
-			break;
-		case 1:
-			success = drillNode();
-			break;
+	//the last preview is already this cut if neither the tool nor the node has moved since
+	std::shared_ptr<CutJob> job = createJob();
+	if(preview && preview->source == job->source && preview->tool == job->tool
+	  && memcmp(preview->toolWorld.m, _toolWorld.m, sizeof(_toolWorld.m)) == 0) {
+		job = preview;
+	} else {
+		job->cutter = &_cutter;
+		job->hullCutters = &_hullCutters;
+		runJob(*job);
 	}
-	if(!success) return false;
+	_cutSource.reset();
+	if(!job->success) return false;
 	
+	usageCount++;
 	app->setAction("tool", _node);
 
-	//transform the new model and convex hull vertices from tool space back to model space and store in the original node
-	Matrix toolModel;
-	_node->_worldMatrix.invert(&toolModel);
-	Matrix::multiply(toolModel, _toolWorld, &toolModel);
-	_node->copyMesh(_newNode);
-	for(i = 0; i < _node->nv(); i++) {
-		toolModel.transformPoint(&_node->_vertices[i]);
-	}
-	for(i = 0; i < _node->_hulls.size(); i++) {
-		MyNode::ConvexHull *hull = _node->_hulls[i];
-		for(j = 0; j < hull->nv(); j++) {
-			toolModel.transformPoint(&hull->_vertices[j]);
-		}
-		hull->setNormals();
+	//the result is already in model space, so it can go straight into the node - setAction has moved
+	//the old mesh and hulls into the undo history
+	_node->Meshy::swapMesh(&job->result);
+	for(short i = 0; i < job->hulls.size(); i++) {
+		job->hulls[i]->_node = _node;
+		_node->_hulls.push_back(std::move(job->hulls[i]));
 	}
+	_node->_objType = "mesh";
 	//put all the changes into the simulation
 	_node->updateModel();
 
 	app->commitAction();
-}
-
-bool ToolMode::checkEdgeInt(unsigned short v1, unsigned short v2) {
-	if(edgeInt.find(v1) == edgeInt.end() || edgeInt[v1].find(v2) == edgeInt[v1].end()) return false;
-	_tempInt = edgeInt[v1][v2];
 	return true;
 }
 
-void ToolMode::addToolEdge(unsigned short v1, unsigned short v2, unsigned short lineNum) {
-	_next[v1] = v2;
-	segmentEdges[lineNum][v2] = v1;
-}
-
-short ToolMode::addToolInt(Vector3 &v, unsigned short line, unsigned short face, short segment) {
-	short n = _newMesh->nv();
-	_newMesh->addVertex(v);
-	os.str("");
-	os << "line " << line << " => face " << face << " [" << usageCount << "]";
-	_newMesh->setVInfo(n, os.str().c_str());
-	toolInt[line][face] = n;
-	if(segment >= 0) addToolEdge(_lastInter, n, segment);
-	_lastInter = n;
-	return n;
-}
-
-void ToolMode::showFace(Meshy *mesh, std::vector<unsigned short> &face, bool world) {
-	_node->setWireframe(true);
-	app->_drawDebug = false;
-	short n = face.size(), i;
-	Vector3 vec;
-	std::vector<Vector3> vFace(n);
-	for(i = 0; i < n; i++) {
-		_toolWorld.transformPoint(mesh->_vertices[face[i]], &vFace[i]);
+//snapshot everything a cut needs so it can run on any thread - the node's geometry is only copied again once it moves
+std::shared_ptr<ToolMode::CutJob> ToolMode::createJob() {
+	_node = _selectedNode;
+	_node->updateTransform();
+	Matrix world = _node->getWorldMatrix();
+	if(!_cutSource || _cutSource->node != _node || memcmp(_cutSource->world.m, world.m, sizeof(world.m)) != 0) {
+		CutSource *source = new CutSource();
+		source->node = _node;
+		source->world = world;
+		source->mesh.copyMesh(_node);
+		source->mesh._vertices = _node->_worldVertices;
+		for(short i = 0; i < _node->_hulls.size(); i++) {
+			MyNode::ConvexHull *hull = _node->_hulls[i].get(), *copy = new MyNode::ConvexHull(NULL);
+			copy->copyMesh(hull);
+			copy->_vertices = hull->_worldVertices;
+			source->hulls.push_back(std::unique_ptr<MyNode::ConvexHull>(copy));
+		}
+		_cutSource = std::shared_ptr<CutSource>(source);
 	}
-	app->showFace(mesh, vFace);
-	mesh->printFace(face);
+	std::shared_ptr<CutJob> job(new CutJob());
+	job->source = _cutSource;
+	job->tool = getTool();
+	job->toolWorld = _tool->getWorldMatrix();
+	job->cancelled = false;
+	job->success = false;
+	job->cutter = NULL;
+	job->hullCutters = NULL;
+	return job;
 }
 
-void ToolMode::getEdgeInt(bool (ToolMode::*getInt)(unsigned short*, short*, float*)) {
-	short i, j, k, line[2];
-	unsigned short e[2];
-	float dist[2];
-	std::map<unsigned short, std::map<unsigned short, short> >::iterator it;
-	std::map<unsigned short, short>::iterator vit;
-	for(it = _mesh->_edgeInd.begin(); it != _mesh->_edgeInd.end(); it++) {
-		e[0] = it->first;
-		for(vit = it->second.begin(); vit != it->second.end(); vit++) {
-			e[1] = vit->first;
-			if(e[1] < e[0]) continue;
-			if(!((this->*getInt)(e, line, dist))) continue;
-			for(j = 0; j < 2; j++) if(line[j] >= 0) {
-				k = _newMesh->_vertices.size();
-				_newMesh->_vertices.push_back(toolVertices[e[j]]
-				  + (toolVertices[e[(j+1)%2]] - toolVertices[e[j]]) * dist[j]);
-				os.str("");
-				os << "edge " << e[j] << "-" << e[(j+1)%2] << " => line " << line[j] << " [" << usageCount << "]";
-				_newMesh->setVInfo(k, os.str().c_str());
-				edgeInt[e[j]][e[(j+1)%2]] = std::pair<unsigned short, unsigned short>(line[j], k);
-			}
-			for(j = 0; j < 2; j++) if(line[j] < 0) edgeInt[e[j]][e[(j+1)%2]] = edgeInt[e[(j+1)%2]][e[j]];
-		}
+//cut the tool out of the job's source, leaving the result on the job in model space - only touches the job
+//and its cutters, so it is safe off the main thread
+void ToolMode::runJob(CutJob &job) {
+	MeshBoolean *cutter = job.cutter;
+	Meshy &mesh = job.source->mesh;
+	short nv = mesh.nv(), i;
+	Matrix toolInv;
+	job.toolWorld.invert(&toolInv);
+	job.vertices.resize(nv);
+	for(i = 0; i < nv; i++) toolInv.transformPoint(mesh._vertices[i], &job.vertices[i]);
+
+	//each tool type just says which planes bound it - the cutter does the rest
+	cutter->setCancel(&job.cancelled);
+	cutter->clear();
+	cutter->setExtent(job.vertices);
+	job.planes.clear();
+	switch(job.tool->type) {
+		case 0:
+			job.success = sawNode(job);
+			break;
+		case 1:
+			job.success = drillNode(job);
+			break;
 	}
-}
+	cutter->setCancel(NULL);
+	if(job.cancelled) job.success = false;
+	if(!job.success) return;
 
-void printCycles(Meshy *mesh, std::map<unsigned short, unsigned short> edges) {
-	short p, q, start;
-	while(!edges.empty()) {
-		start = edges.begin()->first;
-		p = start;
-		do {
-			mesh->printVertex(p);
-			q = edges[p];
-			edges.erase(p);
-			p = q;
-		} while(edges.find(p) != edges.end());
-		if(p == start) cout << "COMPLETE";
-		else mesh->printVertex(p);
-		cout << endl;
+	//transform the new model from tool space back to model space - the hull threads already did theirs
+	Matrix toolModel;
+	job.source->world.invert(&toolModel);
+	Matrix::multiply(toolModel, job.toolWorld, &toolModel);
+	for(i = 0; i < job.result.nv(); i++) {
+		toolModel.transformPoint(&job.result._vertices[i]);
 	}
 }
 
-//given an edge map of vertices in a plane, resolve it to a set of faces and add it to the new mesh
-void ToolMode::getNewFaces(std::map<unsigned short, unsigned short> &edges, Vector3 normal) {
-
-	std::map<unsigned short, unsigned short> oldEdges = edges;
-
-	short p, q, i, j, k, m, n;
-	bool isBorder;
-	std::vector<unsigned short> cycle, border;
-	std::vector<std::vector<unsigned short> > borders, holes;
-	std::map<unsigned short, unsigned short>::iterator it;
-	//make a 2D coordinate system for the plane and project all vertices in the edge map into it
-	Vector3 vx, vy, vec;
-	normal.normalize();
-	Vector3::cross(normal, Vector3::unitX(), &vx);
-	if(vx.length() < 0.01f) Vector3::cross(normal, Vector3::unitY(), &vx);
-	vx.normalize();
-	Vector3::cross(normal, vx, &vy);
-	vy.normalize();
-	std::map<unsigned short, Vector2> planeVertices;
-	for(it = edges.begin(); it != edges.end(); it++) {
-		p = it->first;
-		vec = _newMesh->_vertices[p];
-		planeVertices[p].set(vec.dot(vx), vec.dot(vy));
-	}
-	//get all cycles - partition into borders and holes
-	while(!edges.empty()) {
-		cycle.clear();
-		it = edges.begin();
-		p = it->first;
-		do {
-			cycle.push_back(p);
-			q = edges[p];
-			edges.erase(p);
-			p = q;
-		} while(edges.find(p) != edges.end());
-		if(p != cycle[0]) {
-			if(_hullNum >= 0) cout << " Hull " << _hullNum << ", slice " << _hullSlice << endl;
-			if(_faceNum >= 0) {
-				cout << " Face " << _faceNum << ": ";
-				Face &face = _mesh->_faces[_faceNum];
-				for(i = 0; i < face.size(); i++) cout << face[i] << " => " << keep[face[i]] << ", ";
-				cout << endl;
-			}
-			cout << "Cycles:" << endl;
-			printCycles(_newMesh, oldEdges);
-			//GP_ERROR("Couldn't finish cycle");
-			continue;
-		}
-		isBorder = _newMesh->getNormal(cycle, true).dot(normal) > 0;
-		if(isBorder) borders.push_back(cycle);
-		else holes.push_back(cycle);
-	}
-	//for each hole, find which border it belongs in
-	short n1, n2, numFaces = borders.size(), numHoles = holes.size();
-	if(numFaces == 0) return;
-	std::vector<std::vector<unsigned short> > borderHoles(numFaces);
-	Vector2 norm, v1, v2, v3;
-	for(i = 0; i < numHoles; i++) {
-		cycle = holes[i];
-		n1 = cycle.size();
-		float min = 2;
-		short best = 0;
-		if(numFaces > 1) for(j = 0; j < numFaces; j++) {
-			border = borders[j];
-			n2 = border.size();
-			//cast a ray from each vertex of the hole, and take the avg # of intersections with border edges
-			//closer it is to an odd number, more likely hole is inside
-			float avg = 0;
-			for(k = 0; k < n1; k++) {
-				norm.set(0, 0);
-				for(m = 0; m < 2; m++) {
-					v1 = planeVertices[cycle[(k+m)%n1]] - planeVertices[cycle[(k+m-1+n1)%n1]];
-					v1.set(-v1.y, v1.x);
-					norm += v1.normalize();
-				}
-				norm.normalize();
-				short inter = 0;
-				for(m = 0; m < n2; m++) {
-					v2 = planeVertices[border[m]];
-					v3 = planeVertices[border[(m+1)%n2]] - v2;
-					float det = norm.x * v3.y - norm.y * v3.x;
-					if(det == 0) continue;
-					v2 -= planeVertices[cycle[k]];
-					float dist = (-norm.y * v2.x + norm.x * v2.y) / det;
-					if(dist > 0 && dist < 1) inter++;
-				}
-				avg += inter % 2;
-			}
-			avg /= n1;
-			if(avg < min) {
-				min = avg;
-				best = j;
-			}
+//subtract the tool from the model and from each of its convex hulls, leaving the model on the job in tool space
+//and the hulls in model space
+void ToolMode::cutNode(CutJob &job) {
+	CutSource &source = *job.source;
+	short nh = source.hulls.size(), nt = job.planes.size(), numThreads = 0, i, j;
+	//hulls don't depend on each other or on the visual mesh, so they are cut alongside it, each thread with a
+	//kernel of its own - hull i goes to thread i % numThreads and the pieces are gathered back in hull order
+	std::vector<MeshBoolean::CutPlane> tool(nt);
+	for(i = 0; i < nt; i++) tool[i] = job.cutter->_planes[job.planes[i]];
+	std::vector<std::vector<std::unique_ptr<MyNode::ConvexHull> > > pieces(nh);
+	std::vector<std::thread> threads;
+	if(nh > 0) {
+		numThreads = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+		numThreads = std::min(numThreads, nh);
+		if(job.hullCutters->size() < numThreads) job.hullCutters->resize(numThreads);
+		for(i = 0; i < numThreads; i++) {
+			threads.push_back(std::thread(&ToolMode::cutHulls, this, std::ref(job), std::cref(tool), i, numThreads,
+			  std::ref(pieces)));
 		}
-		borderHoles[best].push_back(i);
 	}
-	//for each border, add its holes and triangulate!
-	Face newFace(_newMesh);
-	for(i = 0; i < numFaces; i++) {
-		newFace.set(borders[i]);
-		for(j = 0; j < borderHoles[i].size(); j++)
-			newFace.addHole(holes[borderHoles[i][j]]);
-		_newMesh->addFace(newFace);
+	job.result.clearMesh();
+	job.cutter->subtract(&source.mesh, job.vertices, job.planes, &job.result);
+	for(i = 0; i < threads.size(); i++) threads[i].join();
+
+	job.hulls.clear();
+	for(i = 0; i < nh; i++) {
+		for(j = 0; j < pieces[i].size(); j++) job.hulls.push_back(std::move(pieces[i][j]));
 	}
 }
 
-void ToolMode::addToolFaces() {
-	_faceNum = -1;
-	Tool *tool = getTool();
-	short _segments, i, j, k, m, n, p, q, lineNum, toolLineNum, numInt, e[2];
-	float distance, dAngle, angle;
-	_segments = _subMode == 1 ? _hullSlice >= 0 ? 3 : tool->iparam[0] : 1;
-	if(_subMode == 1) dAngle = 2*M_PI / tool->iparam[0];
-	Vector3 v1, v2;
-	//for any tool line that has intersections, order them by distance along the line
-	std::vector<std::vector<std::pair<float, unsigned short> > > lineInt(_segments);
-	std::map<unsigned short, bool> enterInt;
-	std::map<unsigned short, std::map<unsigned short, unsigned short> >::iterator it;
-	std::map<unsigned short, unsigned short>::iterator it1;
-	for(it = toolInt.begin(); it != toolInt.end(); it++) {
-		lineNum = it->first;
-		//sort the drill line intersections by distance along the ray
-		for(it1 = toolInt[lineNum].begin(); it1 != toolInt[lineNum].end(); it1++) {
-			n = it1->second;
-			distance = _newMesh->_vertices[n].z;
-			lineInt[lineNum].push_back(std::pair<float, unsigned short>(distance, n));
-			enterInt[n] = toolPlanes[it1->first].getNormal().z < 0;
+//cut this thread's share of the hulls and put them in model space - pieces[i] holds what is left of hull i
+void ToolMode::cutHulls(CutJob &job, const std::vector<MeshBoolean::CutPlane> &tool, short thread, short numThreads,
+  std::vector<std::vector<std::unique_ptr<MyNode::ConvexHull> > > &pieces) {
+	MeshBoolean &cutter = (*job.hullCutters)[thread];
+	CutSource &source = *job.source;
+	short nh = source.hulls.size(), nt = tool.size(), i, j, k;
+	cutter.setCancel(&job.cancelled);
+	cutter.clear();
+	cutter.setExtent(job.vertices);
+	std::vector<int> planes(nt);
+	for(i = 0; i < nt; i++) planes[i] = cutter.addPlane(tool[i].a, tool[i].b, tool[i].c, tool[i].d);
+
+	Matrix toolInv, toolModel;
+	job.toolWorld.invert(&toolInv);
+	source.world.invert(&toolModel);
+	Matrix::multiply(toolModel, job.toolWorld, &toolModel);
+	std::vector<Vector3> vertices;
+	std::vector<Plane> facePlanes;
+	std::vector<int> solid;
+	std::vector<std::vector<MeshBoolean::CutPolygon> > polygons;
+	for(i = thread; i < nh && !cutter.cancelled(); i += numThreads) {
+		MyNode::ConvexHull *hull = source.hulls[i].get(), *newHull;
+		short nv = hull->nv(), nf = hull->nf();
+		vertices.resize(nv);
+		for(j = 0; j < nv; j++) toolInv.transformPoint(hull->_vertices[j], &vertices[j]);
+		//a hull wholly in front of any tool plane is untouched
+		for(j = 0; j < nt; j++) {
+			for(k = 0; k < nv && cutter.pointSide(vertices[k], planes[j]) > 0; k++);
+			if(k == nv) break;
 		}
-		std::sort(lineInt[lineNum].begin(), lineInt[lineNum].end());
-		//now they are ordered, note the edges they form
-		numInt = lineInt[lineNum].size();
-		for(i = 0; i < numInt-1; i++) {
-			for(j = 0; j < 2; j++) e[j] = lineInt[lineNum][i+j].second;
-			//due to round off error, can't afford to be too zealous - so just treat each adjacent pair as an edge
-			if(i % 2 == 0) { //i < numInt-1 && enterInt[e[0]] && !enterInt[e[1]]) {
-				addToolEdge(e[1], e[0], lineNum);
-				addToolEdge(e[0], e[1], (lineNum-1+_segments)%_segments);
+		if(j < nt) {
+			newHull = new MyNode::ConvexHull(NULL);
+			newHull->copyMesh(hull);
+			newHull->_vertices = vertices;
+			pieces[i].push_back(std::unique_ptr<MyNode::ConvexHull>(newHull));
+		} else {
+			//otherwise what is left of it is one convex piece per tool plane it reaches out past
+			facePlanes.resize(nf);
+			for(j = 0; j < nf; j++) {
+				facePlanes[j] = hull->_faces[j].getPlane();
+				facePlanes[j].transform(toolInv);
+			}
+			solid.clear();
+			polygons.clear();
+			cutter.solidPlanes(facePlanes, solid);
+			cutter.subtractConvex(solid, planes, polygons);
+			for(j = 0; j < polygons.size(); j++) {
+				newHull = new MyNode::ConvexHull(NULL);
+				cutter.beginOutput(newHull);
+				cutter.addPolygons(polygons[j]);
+				pieces[i].push_back(std::unique_ptr<MyNode::ConvexHull>(newHull));
 			}
 		}
-	}
-	
-	//for each segment of the tool, use its known set of points and edges to determine all its faces
-	Vector3 normal;
-	for(i = 0; i < _segments; i++) {
-		switch(_subMode) {
-			case 0: normal.set(1, 0, 0); break;
-			case 1:
-				if(_hullSlice >= 0) {
-					angle = (_hullSlice + i/2.0f) * dAngle;
-					if(i%2 == 0) normal.set((1-i) * sin(angle), (i-1) * cos(angle), 0);
-					else normal.set(-cos(angle), -sin(angle), 0);
-				} else {
-					angle = i * dAngle + dAngle/2;
-					normal.set(-cos(angle), -sin(angle), 0);
-				}
-				break;
+		for(j = 0; j < pieces[i].size(); j++) {
+			newHull = pieces[i][j].get();
+			for(k = 0; k < newHull->nv(); k++) toolModel.transformPoint(&newHull->_vertices[k]);
+			newHull->setNormals();
 		}
-		getNewFaces(segmentEdges[i], normal);
 	}
+	cutter.setCancel(NULL);
 }
 
-/************ SAWING ************/
-
-bool ToolMode::sawNode() {
-	short i, j, k, m, n, p, q, r, nh = _node->_hulls.size();
-	float f1, f2, f3, f4;
-	
-	planes.resize(1);
-	planes[0].set(Vector3::unitX(), 0);
-	planes[0].transform(_tool->getWorldMatrix());
-	
-	for(r = 0; r < 1 + nh; r++) {
-		if(r > 0) {
-			setMesh(_node->_hulls[r-1]);
-			MyNode::ConvexHull *hull = new MyNode::ConvexHull(_newNode);
-			_newNode->_hulls.push_back(hull);
-			_newMesh = hull;
-		}
-		short nv = _mesh->nv(), nf = _mesh->nf();
+/************ PREVIEW ************/
+
+//queue a cut for the tool's current pose - it replaces any queued one and tells a running one to give up
+void ToolMode::requestPreview() {
+	if(_selectedNode == NULL || app->_headless) return;
+	std::shared_ptr<CutJob> job = createJob();
+	_previewMutex.lock();
+	if(_previewRunning) _previewRunning->cancelled = true;
+	_previewRequest = job;
+	_previewMutex.unlock();
+	if(!_previewThread.joinable()) _previewThread = std::thread(&ToolMode::previewLoop, this);
+	_previewWake.notify_all();
+}
 
-		for(i = 0; i < nv; i++) {
-			if(toolVertices[i].x < 0) {
-				keep[i] = _newMesh->_vertices.size();
-				_newMesh->_vertices.push_back(toolVertices[i]);
-			} else keep[i] = -1;
-		}
+//drop any queued or running preview and hide the ghost
+void ToolMode::stopPreview() {
+	_previewMutex.lock();
+	if(_previewRunning) _previewRunning->cancelled = true;
+	_previewRequest.reset();
+	_preview.reset();
+	_previewMutex.unlock();
+	showGhost(std::shared_ptr<CutJob>());
+}
 
-		edgeInt.clear();	
-		getEdgeInt(&ToolMode::getEdgeSawInt);
-	
-		Face face, newFace(_newMesh);
-		std::vector<unsigned short> keeping;
-		std::list<std::pair<float, unsigned short> > intList;
-		std::list<std::pair<float, unsigned short> >::iterator lit;
-		std::map<unsigned short, unsigned short> intPair;
-		for(i = 0; i < nf; i++) {
-			face = _mesh->_faces[i];
-			n = face.size();
-			//sort the edge intersections by distance
-			Vector3 first, dir = Vector3::zero(), v1;
-			short intCount = 0;
-			keeping.clear();
-			intList.clear();
-			for(j = 0; j < n; j++) {
-				p = face[j];
-				q = face[(j+1)%n];
-				if(keep[p] >= 0) keeping.push_back(j);
-				if(checkEdgeInt(p, q)) {
-					intCount++;
-					v1 = _newMesh->_vertices[_tempInt.second];
-					if(intCount == 1) first = v1;
-					else if(intCount == 2) {
-						dir = v1 - first;
-						dir.normalize();
-					}
-					float distance = (v1 - first).dot(dir);
-					intList.push_back(std::pair<float, unsigned short>(distance, j));
-				}
-			}
-			intList.sort();
-			intPair.clear();
-			for(lit = intList.begin(); lit != intList.end(); lit++) {
-				p = (lit++)->second;
-				q = lit->second;
-				intPair[p] = q;
-				intPair[q] = p;
-			}
-		
-			while(!keeping.empty()) {
-				newFace.clear();
-				j = keeping.back();
-				do {
-					p = face[j];
-					q = face[(j+1)%n];
-					if(keep[p] >= 0) {
-						keeping.erase(std::find(keeping.begin(), keeping.end(), j));
-						newFace.push_back(keep[p]);
-					}
-					if(checkEdgeInt(p, q)) {
-						newFace.push_back(_tempInt.second);
-						j = intPair[j];
-						m = edgeInt[face[j]][face[(j+1)%n]].second;
-						newFace.push_back(m);
-						addToolEdge(m, _tempInt.second, 0);
-					}
-					j = (j+1)%n;
-				} while(keep[face[j]] != newFace[0]);
-				if(newFace.size() > 0) _newMesh->addFace(newFace);
-			}
-		}
-		addToolFaces();
+void ToolMode::previewLoop() {
+	std::unique_lock<std::mutex> lock(_previewMutex);
+	while(true) {
+		while(!_previewQuit && !_previewRequest) _previewWake.wait(lock);
+		if(_previewQuit) return;
+		std::shared_ptr<CutJob> job = _previewRequest;
+		_previewRequest.reset();
+		_previewRunning = job;
+		lock.unlock();
+		job->cutter = &_previewCutter;
+		job->hullCutters = &_previewHullCutters;
+		runJob(*job);
+		lock.lock();
+		_previewRunning.reset();
+		if(job->success && !job->cancelled) _preview = job;
+		_previewWake.notify_all();
 	}
-	return true;
 }
 
-bool ToolMode::getEdgeSawInt(unsigned short *e, short *lineInd, float *dist) {
-	if((keep[e[0]] < 0) == (keep[e[1]] < 0)) return false;
-	short keeper = keep[e[0]] < 0 ? 1 : 0, other = 1-keeper;
-	float delta = toolVertices[e[keeper]].x - toolVertices[e[other]].x;
-	dist[keeper] = delta == 0 ? 0 : toolVertices[e[keeper]].x / delta;
-	lineInd[keeper] = 0;
-	lineInd[other] = -1;
-	return true;
+void ToolMode::update() {
+	Mode::update();
+	_previewMutex.lock();
+	std::shared_ptr<CutJob> preview = _preview;
+	_previewMutex.unlock();
+	if(preview && preview != _ghostJob && preview->source == _cutSource) showGhost(preview);
 }
 
-
-/************ DRILLING ***************/
-
-bool ToolMode::drillNode() {
-
-	Tool *tool = getTool();
-	float _radius = tool->fparam[0];
-	int _segments = tool->iparam[0];
-	float angle, dAngle = 2*M_PI/_segments, planeDistance = _radius * cos(dAngle/2);
-
-	//temp variables
-	short i, j, k, m, n, p, q, r;
-	float f1, f2, f3, f4, s, t, f[4];
-	Vector3 v1, v2, v3, v4, v[4], drillVec;
-
-	//determine which vertices to discard because they are inside the drill cylinder
-	for(i = 0; i < _mesh->_vertices.size(); i++) {
-		if(drillKeep(i)) {
-			keep[i] = _newMesh->_vertices.size();
-			_newMesh->_vertices.push_back(toolVertices[i]);
-			_newMesh->_vInfo.push_back(_mesh->_vInfo[i]);
-		} else keep[i] = -1;
+//show the result of a cut as a translucent copy of the node, or hide it if there is none
+void ToolMode::showGhost(std::shared_ptr<CutJob> job) {
+	if(!job) {
+		if(_ghost->getScene()) _scene->removeNode(_ghost);
+		_ghostJob.reset();
+		return;
 	}
+	_ghost->Meshy::copyMesh(&job->result);
+	_ghost->set(job->source->world);
+	_ghost->updateModel(false, false);
+	_ghost->setColor(0.3f, 0.8f, 1.0f, 0.5f);
+	if(!_ghost->getScene()) _scene->addNode(_ghost);
+	app->invalidateRenderQueues();
+	_ghostJob = job;
+}
 
-	//find all intersections between edges of the model and the planes of the drill bit
-	getEdgeInt(&ToolMode::getEdgeDrillInt);
-	
-	//loop around each original face, building modified faces according to the drill intersections
-	bool ccw, drillInside, found, parallel, isBorder;
-	short dir, offset, start, cycleStart, line, startLine, endLine, nf = _mesh->_faces.size();
-	float distance, faceDistance;
-	Plane facePlane;
-	Vector3 faceNormal;
-	Face::boundary_iterator bit;
-	std::vector<unsigned short> triangle(3), newFace;
-	for(i = 0; i < nf; i++) {
-		_faceNum = i;
-	
-		Face &face = _mesh->_faces[i];
-
-		for(k = 0, bit = face.vbegin(); bit != face.vend(); bit++) if(keep[bit->first] >= 0) k++;
-		if(k == 0) continue; //not keeping any part of this face
-
-		faceNormal = toolPlanes[i].getNormal();
-		faceDistance = toolPlanes[i].getDistance();
-		parallel = faceNormal.z == 0;
-		ccw = faceNormal.z < 0;
-		dir = ccw ? 1 : -1;
-
-		drillInside = false;
-		_next.clear();
-		
-		n = face.nt();
-
-		for(j = 0; j < n; j++) {
-			triangle = face._triangles[j];
-			//if we are not keeping any of the 3 vertices, we are done here
-			for(k = 0; k < 3 && keep[triangle[k]] < 0; k++);
-			if(k == 3) continue;
-			//start on an edge intersection exiting the drill, if any
-			for(k = 0; k < 3 && (keep[triangle[(k+1)%3]] < 0 || !checkEdgeInt(triangle[(k+1)%3], triangle[k])); k++);
-			if(k < 3) {
-				start = k;
-				do {
-					//walk from the exiting intersection to the next entering intersection
-					newFace.clear();
-					endLine = _tempInt.first;
-					cycleStart = _tempInt.second;
-					_lastInter = cycleStart;
-					newFace.push_back(cycleStart);
-					do {
-						//if this is a boundary edge, keep it that way
-						p = triangle[k];
-						q = triangle[(k+1)%3];
-						r = triangle[(k+2)%3];
-						if(_mesh->_edgeInd[p][q] == i) _next[_lastInter] = keep[q];
-						_lastInter = keep[q];
-						k = (k+1)%3;
-						newFace.push_back(keep[q]);
-					} while(!checkEdgeInt(q, r));
-					if(_mesh->_edgeInd[q][r] == i) _next[_lastInter] = _tempInt.second;
-					startLine = _tempInt.first;
-					_lastInter = _tempInt.second;
-					newFace.push_back(_lastInter);
-					if(parallel) {
-						//if parallel, it's not clear which way the face circulates wrt the drill, but we know it should
-						//not span more than 2 segments, so just go the direction of the fewest segments
-						dir = (endLine+_segments)%_segments - startLine < _segments/2 ? 1 : -1;
-						//it's also not clear where a drill line intersects the face,
-						//so use the midpoint of the edge intersections to ensure we are inside the face
-						distance = (_newMesh->_vertices[cycleStart].z + _newMesh->_vertices[_lastInter].z) / 2;
-					}
-					offset = dir == 1 ? 1 : 0;
-					//walk the drill to bridge the edge intersections and complete the new face
-					startLine = (startLine + offset) % _segments;
-					endLine = (endLine + offset) % _segments;
-					//if(startLine == (endLine+dir+_segments)%_segments) GP_ERROR("ALOHA");
-					short nTool = 0;
-					for(line = startLine; line != endLine; line = (line+dir+_segments)%_segments) {
-						v1.set(_radius * cos(line*dAngle), _radius * sin(line*dAngle), 0);
-						if(parallel) v1.z = distance;
-						else v1.z = -(v1.dot(faceNormal) + faceDistance) / faceNormal.z;
-						addToolInt(v1, line, i, (line-offset+_segments)%_segments);
-						newFace.push_back(_lastInter);
-						nTool++;
-					}
-					if(nTool >= _segments) GP_ERROR("HELLO");
-					addToolEdge(_lastInter, cycleStart, (endLine-offset+_segments)%_segments);
-					//find the next exiting edge intersection
-					while(keep[triangle[(k+1)%3]] < 0 || !checkEdgeInt(triangle[(k+1)%3], triangle[k])) k = (k+1)%3;
-				} while(k != start);
-			} else { //if no edge intersections, this triangle either is unmodified or contains the drill
-				//check if the drill is inside
-				if(!parallel) {
-					v1 = toolVertices[triangle[1]] - toolVertices[triangle[0]];
-					v2 = toolVertices[triangle[2]] - toolVertices[triangle[0]];
-					v3 = -toolVertices[triangle[0]];
-					//[v1 v2][a b] = v3 => [a b] = [v1 v2]^-1 * v3
-					float det = v1.x * v2.y - v2.x * v1.y, a, b;
-					if(det != 0) {
-						a = (v2.y * v3.x - v2.x * v3.y) / det;
-						b = (-v1.y * v3.x + v1.x * v3.y) / det;
-						if(a > 0 && b > 0 && a+b < 1) drillInside = true;
-					}
-				}
-				if(drillInside) {
-					for(k = 0; k < _segments; k++) {
-						v1.set(_radius * cos(k*dAngle), _radius * sin(k*dAngle), 0);
-						v1.z = -(v1.dot(faceNormal) + faceDistance) / faceNormal.z;
-						addToolInt(v1, k, i);
-					}
-					for(k = 0; k < _segments; k++) {
-						addToolEdge(toolInt[k][i], toolInt[(k-dir+_segments)%_segments][i], (k-(dir+1)/2+_segments)%_segments);
-					}
-				}
-				//either way, all 3 edges are being kept
-				for(k = 0; k < 3; k++) {
-					p = triangle[k];
-					q = triangle[(k+1)%3];
-					if(_mesh->_edgeInd[p][q] == i) _next[keep[p]] = keep[q];
-				}
-			}
-		}
-		//convert the edge map we laid out above into a set of one or more new faces
-		getNewFaces(_next, faceNormal);
-	}
-	addToolFaces();
-	
-	//split convex hulls using the radial and tangential planes of the drill
-	short nh = _node->_hulls.size();
-	MyNode::ConvexHull *hull, *newHull;
-	std::vector<bool> keepDrill;
-	unsigned short e[2];
-	for(i = 0; i < nh; i++) {
-		_hullNum = i;
-		hull = _node->_hulls[i];
-		setMesh(hull);
-		short nv = hull->nv(), nf = hull->nf(), numKeep = 0, faceSize;
-		keepDrill.resize(nv);
-		for(j = 0; j < nv; j++) {
-			keepDrill[j] = drillKeep(j);
-			if(keepDrill[j]) numKeep++;
-		}
-		if(numKeep == 0) continue;
-		//for each drill segment, if the hull intersects its angle range, build a new hull from the intersection
-		for(j = 0; j < _segments; j++) {
-			_hullSlice = j;
-			newHull = new MyNode::ConvexHull(_newNode);
-			_newMesh = newHull;
-			edgeInt.clear();
-			toolInt.clear();
-			segmentEdges.clear();
-			float minAngle = j * dAngle, maxAngle = (j+1) * dAngle;
-			short start, lastPlane, plane;
-			//determine which vertices are included
-			numKeep = 0;
-			for(k = 0; k < nv; k++) {
-				angle = atan2(toolVertices[k].y, toolVertices[k].x);
-				if(angle < 0) angle += 2*M_PI;
-				if(keepDrill[k] && angle > minAngle && angle < maxAngle) {
-					keep[k] = newHull->_vertices.size();
-					newHull->_vertices.push_back(toolVertices[k]);
-					numKeep++;
-				} else keep[k] = -1;
-			}
-			//find all edge intersections
-			getEdgeInt(&ToolMode::getHullSliceInt);
-			if(numKeep == 0 && edgeInt.empty()) continue;
-			_newNode->_hulls.push_back(newHull);
-			//build modified faces
-			for(k = 0; k < nf; k++) {
-				_faceNum = k;
-				faceSize = hull->_faces[k].size();
-				cycleStart = -1;
-				lastPlane = -1;
-				_lastInter = -1;
-				facePlane = toolPlanes[k];
-				faceNormal = facePlane.getNormal();
-				faceDistance = facePlane.getDistance();
-				ccw = faceNormal.z < 0;
-				parallel = faceNormal.z == 0;
-				newFace.clear();
-				
-				//start on a vertex we are keeping, if any
-				for(start = 0; start < faceSize && keep[hull->_faces[k][start]] < 0; start++);
-				//if not, look for an edge intersection exiting the segment
-				if(start == faceSize) for(start = 0; start < faceSize; start++) {
-					for(m = 0; m < 2; m++) e[m] = hull->_faces[k][(start+m)%faceSize];
-					if(keep[e[1]] < 0 && checkEdgeInt(e[1], e[0])) {
-						lastPlane = _tempInt.first;
-						cycleStart = _tempInt.second;
-						newFace.push_back(cycleStart);
-						_lastInter = cycleStart;
-						start = (start+1) % faceSize;
-						break;
-					}
-				}
-				//if none of those either, we are discarding the whole face
-				if(start == faceSize) continue;
-				//otherwise, loop around the face adding kept vertices and intersections
-				for(r = 0; r < faceSize; r++) {
-					m = (start+r) % faceSize;
-					for(n = 0; n < 2; n++) e[n] = hull->_faces[k][(m+n)%faceSize];
-					if(keep[e[0]] >= 0) newFace.push_back(keep[e[0]]);
-					if(checkEdgeInt(e[0], e[1])) {
-						plane = _tempInt.first;
-						p = _tempInt.second;
-						//if we are re-entering the segment on a different plane than we exited,
-						//the drill lines in between those planes must intersect the face
-						if(keep[e[0]] < 0 && lastPlane >= 0 && lastPlane != plane) {
-							dir = plane > lastPlane ? 1 : -1;
-							offset = dir == 1 ? 0 : -1;
-							if(parallel) distance = (_newMesh->_vertices[_lastInter].z + _newMesh->_vertices[p].z) / 2;
-							for(n = lastPlane + offset; n != plane + offset; n += dir) {
-								line = (j+n) % _segments;
-								v1.set(_radius * cos(line*dAngle), _radius * sin(line*dAngle), 0);
-								if(parallel) v1.z = distance;
-								else v1.z = -(v1.dot(faceNormal) + faceDistance) / faceNormal.z;
-								newFace.push_back(addToolInt(v1, n+1, k, n-offset));
-							}
-						}
-						newFace.push_back(p);
-						if(keep[e[0]] < 0) addToolEdge(_lastInter, p, plane);
-						q = edgeInt[e[1]][e[0]].second;
-						if(q != p && q != cycleStart) newFace.push_back(q);
-						if(keep[e[1]] < 0) {
-							lastPlane = edgeInt[e[1]][e[0]].first;
-							_lastInter = q;
-						}
-					}
-				}
-				if(!newFace.empty()) newHull->addFace(newFace);
-			}
-			addToolFaces();
-		}
+void ToolMode::showFace(Meshy *mesh, std::vector<unsigned short> &face, bool world) {
+	_node->setWireframe(true);
+	app->_drawDebug = false;
+	short n = face.size(), i;
+	Vector3 vec;
+	std::vector<Vector3> vFace(n);
+	for(i = 0; i < n; i++) {
+		_toolWorld.transformPoint(mesh->_vertices[face[i]], &vFace[i]);
 	}
-	return true;
+	app->showFace(mesh, vFace);
+	mesh->printFace(face);
 }
 
-bool ToolMode::drillKeep(unsigned short n) {
-	Tool *tool = getTool();
-	short _segments = tool->iparam[0];
-	float _radius = tool->fparam[0], dAngle = 2*M_PI / _segments, planeDistance = _radius * cos(dAngle/2);
+/************ SAWING ************/
 
-	Vector3 test = toolVertices[n];
-	float testAngle = atan2(test.y, test.x);
-	if(testAngle < 0) testAngle += 2*M_PI;
-	float testRadius = sqrt(test.x*test.x + test.y*test.y);
-	float ang = fabs(fmod(testAngle, dAngle) - dAngle/2), radius = planeDistance / cos(ang);
-	return testRadius >= radius;
+bool ToolMode::sawNode(CutJob &job) {
+	//the saw removes everything on the +x side of its plane
+	job.planes.push_back(job.cutter->addPlane(-1, 0, 0, 0));
+	cutNode(job);
+	return true;
 }
 
-bool ToolMode::getEdgeDrillInt(unsigned short *e, short *lineInd, float *distance) {
-	if(keep[e[0]] < 0 && keep[e[1]] < 0) return false;
 
-	Tool *tool = getTool();
-	short _segments = tool->iparam[0], i, j, k;
-	float _radius = tool->fparam[0], f1, f2, f3, d, s, t, angle, dAngle = 2*M_PI / _segments,
-	  planeDistance = _radius * cos(dAngle/2);
-	Vector3 v[3], v1, v2;
+/************ DRILLING ***************/
 
-	for(i = 0; i < 2; i++) {
-		v[i] = toolVertices[e[i]];
-		v[i].z = 0;
-		lineInd[i] = -1;
-	}
-	v[2].set(v[1]-v[0]);
-	//validate the edge is really there
-	if(v[2] == Vector3::zero()) return false;
-	//find the angles where this edge enters and exits the drill circle
-	//|v0 + a*v2| = r => (v0x + a*v2x)^2 + (v0y + a*v2y)^2 = r^2 => |v2|^2 * a^2 + 2*(v0*v2)*a + |v0|^2 - r^2 = 0
-	// => a = [-2*v0*v2 +/- sqrt(4*(v0*v2)^2 - 4*(|v2|^2)*(|v0|^2 - r^2))] / 2*|v2|^2
-	// = [-v0*v2 +/- sqrt((v0*v2)^2 - (|v2|^2)*(|v0|^2 - r^2))] / |v2|^2
-	f1 = v[0].dot(v[2]);
-	f2 = v[0].lengthSquared() - _radius * _radius;
-	f3 = v[2].lengthSquared();
-	d = f1*f1 - f3*f2;
-	if(d < 0) return false; //edge is completely outside drill circle
-	s = (-f1 - sqrt(d)) / f3;
-	t = (-f1 + sqrt(d)) / f3;
-	//neither intersection should be outside the endpoints if we are keeping both of them
-	if((s < 0 || t > 1) && keep[e[0]] >=0 && keep[e[1]] >= 0) return false;
-	//for each edge direction, first get the segment from the angle where it intersects the circle
-	for(j = 0; j < 2; j++) {
-		if(keep[e[j]] < 0) continue;
-		v1.set(v[0] + v[2] * (j == 0 ? s : t));
-		angle = atan2(v1.y, v1.x);
-		if(angle < 0) angle += 2*M_PI;
-		lineInd[j] = (short)(angle / dAngle);
-	}
-	//if keeping both endpoints and they hit the same angle segment, the edge must not really touch the drill plane
-	if(keep[e[0]] >= 0 && keep[e[1]] >= 0 && lineInd[0] == lineInd[1]) return false;
-	//for each edge direction, find the point where it intersects the drill plane in the angle range found above
-	for(j = 0; j < 2; j++) {
-		if(keep[e[j]] < 0) continue;
-		angle = lineInd[j] * dAngle + dAngle/2;
-		v2.set(cos(angle), sin(angle), 0);
-		//(v0 + a*v2) * r = planeDistance => a = (planeDistance - v0*r) / v2*r
-		distance[j] = (planeDistance - v[0].dot(v2)) / v[2].dot(v2);
-		if(j == 1) distance[j] = 1 - distance[j];
-	}
-	return true;
-}
+bool ToolMode::drillNode(CutJob &job) {
+	Tool *tool = job.tool;
+	float radius = tool->fparam[0], angle;
+	int segments = tool->iparam[0];
+	float dAngle = 2*M_PI / segments, planeDistance = radius * cos(dAngle/2);
 
-bool ToolMode::getHullSliceInt(unsigned short *e, short *planeInd, float *dist) {
-	if(keep[e[0]] >= 0 && keep[e[1]] >= 0) return false;
-	
-	Tool *tool = getTool();	
-	short _segments = tool->iparam[0], i, j, k, m, n;
-	float err[2], angle, dAngle = 2*M_PI / _segments, minAngle = _hullSlice * dAngle, maxAngle = (_hullSlice+1) * dAngle,
-	  _radius = tool->fparam[0], planeDistance = _radius * cos(dAngle/2), f1, f2, f3, a, distance, error;
-	Vector3 v[3], v1, v2, normal, tangent;
-	for(m = 0; m < 2; m++) {
-		v[m] = toolVertices[e[m]];
-		v[m].z = 0;
-		err[m] = 1000;
-		dist[m] = 1000;
-		planeInd[m] = -1;
+	//the bit is an n-sided prism along the z-axis, running all the way through the model
+	for(short i = 0; i < segments; i++) {
+		angle = (i + 0.5f) * dAngle;
+		job.planes.push_back(job.cutter->addPlane(cos(angle), sin(angle), 0, -planeDistance));
 	}
-	v[2] = v[1] - v[0];
-	//check radial plane 1, drill plane, radial plane 2
-	bool radial, better;
-	short keeper;
-	for(m = 0; m < 3; m++) {
-		radial = m%2 == 0;
-		keeper = -1;
-		if((keep[e[0]] < 0) != (keep[e[1]] < 0)) keeper = keep[e[0]] < 0 ? 1 : 0;
-		switch(m) {
-			case 0: angle = minAngle; break;
-			case 1: angle = minAngle + dAngle/2; break;
-			case 2: angle = maxAngle; break;
-		}
-		v1.set(cos(angle), sin(angle), 0);
-		v2.set(-sin(angle), cos(angle), 0);
-		normal = radial ? v2 : v1;
-		tangent = radial ? v1 : v2;
-		distance = radial ? 0 : planeDistance;
-		// (v0 + a*v2) * n = distance => a = (distance - v0*n) / v2*n
-		f1 = v[2].dot(normal);
-		f2 = v[0].dot(normal);
-		if(f1 == 0) { //edge is parallel to plane
-			if(keeper >= 0 && fabs(f2) < 0.001f) a = keeper * 1.0f;
-			else continue;
-		} else a = (distance - f2) / f1;
-		if((a < 0 || a > 1) && keeper < 0) continue;
-		v1 = v[0] + a * v[2];
-		if(radial) error = _radius - v1.dot(tangent);
-		else error = fabs(v1.dot(tangent)) - _radius*sin(dAngle/2);
-		if(error <= 0) error = 0;
-		else if(keeper < 0) continue;
-		for(n = 0; n < 2; n++) {
-			if(keeper == 1-n) continue;
-			f1 = n == 0 ? a : 1 - a;
-			if(keeper == n && (err[n] > 0 || dist[n] < 0 || dist[n] > 1)) {
-				float distErr = dist[n] < 0 || dist[n] > 1 ? fmin(fabs(dist[n] - 1), fabs(-dist[n])) : 0,
-				  newErr = a < 0 || a > 1 ? fmin(fabs(a - 1), fabs(-a)) : 0;
-				better = (distErr > err[n] && newErr < distErr) || (err[n] > distErr && error < err[n]);
-			} else better = f1 >= 0 && f1 <= 1 && f1 < dist[n];
-			if(better) {
-				dist[n] = f1;
-				planeInd[n] = m;
-				err[n] = error;
-			}
-		}
-	}
-	if(keeper < 0) return planeInd[0] >= 0 && planeInd[1] >= 0 && planeInd[0] != planeInd[1];
-	else return planeInd[keeper] >= 0;
+	cutNode(job);
+	return true;
 }
 
 }
-
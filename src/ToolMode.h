@@ -2,6 +2,12 @@
 #define TOOLMODE_H_
 
 #include "Mode.h"
+#include "MeshBoolean.h"
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace T4T {
 
@@ -22,7 +28,7 @@ public:
 	short _currentTool;
 	//to display the tool to the user
 	MyNode *_tool;
-	Matrix _toolWorld, _toolInv, _toolNorm;
+	Matrix _toolWorld;
 	//tool translation in xy-plane and rotation about z-axis in its local frame
 	Vector2 _toolTrans;
 	float _toolRot;
@@ -30,12 +36,45 @@ public:
 	Container *_moveMenu, *_bitMenu;
 	short _moveMode;
 
-	MyNode *_node, *_newNode; //a model to hold the modified node data
-	Meshy *_mesh, *_newMesh; //whatever node/hull we are currently working on
+	MyNode *_node, *_newNode; //the node being cut, and the CGAL drill's output - cuts go through a CutJob
+	
+	//the selected node's geometry in world space, copied once so it can be cut off the main thread
+	struct CutSource {
+		MyNode *node;
+		Matrix world;
+		Meshy mesh;
+		std::vector<std::unique_ptr<MyNode::ConvexHull> > hulls;
+	};
+	//one cut of the source by the tool in a given pose - the result is in the node's model space
+	struct CutJob {
+		std::shared_ptr<CutSource> source;
+		Tool *tool;
+		Matrix toolWorld;
+		std::atomic<bool> cancelled;
+		bool success;
+		MeshBoolean *cutter;
+		std::vector<MeshBoolean> *hullCutters; //one per thread that cuts hulls
+		std::vector<int> planes; //the tool is the region behind these planes, in its own frame
+		std::vector<Vector3> vertices; //coords of the mesh vertices in tool frame
+		Meshy result;
+		std::vector<std::unique_ptr<MyNode::ConvexHull> > hulls;
+	};
+	std::shared_ptr<CutSource> _cutSource;
+	
+	//live preview - a worker thread cuts the latest tool pose and the result is shown as a ghost
+	std::thread _previewThread;
+	std::mutex _previewMutex;
+	std::condition_variable _previewWake;
+	std::shared_ptr<CutJob> _previewRequest, _previewRunning, _preview, _ghostJob;
+	bool _previewQuit;
+	MeshBoolean _previewCutter;
+	std::vector<MeshBoolean> _previewHullCutters;
+	MyNode *_ghost;
 	
 	short usageCount;
 
 	ToolMode();
+	~ToolMode();
 	void createBit(short type, ...);
 	void setActive(bool active);
 	bool setSelectedNode(MyNode *node, Vector3 point = Vector3::zero());
@@ -43,49 +82,34 @@ public:
 	void setMoveMode(short mode);
 	void setTool(short n);
 	Tool *getTool();
+	void update();
 	bool touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex);
 	void controlEvent(Control *control, Control::Listener::EventType evt);
 	void placeCamera();
 	void placeTool();
 	bool toolNode();
-	void setMesh(Meshy *mesh);
+	std::shared_ptr<CutJob> createJob();
+	void runJob(CutJob &job);
+	void cutNode(CutJob &job);
+	void cutHulls(CutJob &job, const std::vector<MeshBoolean::CutPlane> &tool, short thread, short numThreads,
+	  std::vector<std::vector<std::unique_ptr<MyNode::ConvexHull> > > &pieces);
+	
+	//preview
+	void requestPreview();
+	void stopPreview();
+	void previewLoop();
+	void showGhost(std::shared_ptr<CutJob> job);
 	
 	//for sawing
-	bool sawNode();
-	bool getEdgeSawInt(unsigned short *e, short *lineInd, float *distance);
+	bool sawNode(CutJob &job);
 	
 	//for drilling
-	bool drillNode();
+	bool drillNode(CutJob &job);
 	bool drillCGAL();
-	bool getEdgeDrillInt(unsigned short *e, short *lineInd, float *distance);
-	bool getHullSliceInt(unsigned short *e, short *planeInd, float *distance);
-	bool drillKeep(unsigned short n);
 	
 	//general purpose
-	Ray _axis; //geometry of the tool
-	std::vector<Ray> lines;
-	std::vector<Plane> planes;
-	Vector3 axis, right, up;
-	std::vector<Vector3> toolVertices; //coords of model vertices in tool frame
-	std::vector<Plane> toolPlanes; //model face planes in tool frame
-	std::vector<short> keep; //-1 if discarding the vertex, otherwise its index in the new model's vertex list
-	//edgeInt[edge vertex 1][edge vertex 2] = (tool plane number, index of intersection point in new model's vertex list)
-	std::map<unsigned short, std::map<unsigned short, std::pair<unsigned short, unsigned short> > > edgeInt;
-	std::pair<unsigned short, unsigned short> _tempInt;
-	//toolInt[tool line #][model face #] = index of line-face intersection in new model's vertex list
-	std::map<unsigned short, std::map<unsigned short, unsigned short> > toolInt;
-	//new edges in tool planes
-	std::map<unsigned short, std::map<unsigned short, unsigned short> > segmentEdges;
-	short _lastInter; //for building edges on the tool surface
-	short _faceNum, _hullNum, _hullSlice; //which convex hull segment we are working on
-	std::map<unsigned short, unsigned short> _next; //new edges for the face currently being tooled
-	
-	void getEdgeInt(bool (ToolMode::*getInt)(unsigned short*, short*, float*));
-	bool checkEdgeInt(unsigned short v1, unsigned short v2);
-	void addToolEdge(unsigned short v1, unsigned short v2, unsigned short lineNum);
-	void getNewFaces(std::map<unsigned short, unsigned short> &edges, Vector3 normal);
-	short addToolInt(Vector3 &v, unsigned short line, unsigned short face, short segment = -1);
-	void addToolFaces();
+	MeshBoolean _cutter; //boolean kernel that does the cutting for every tool
+	std::vector<MeshBoolean> _hullCutters;
 	
 	//debugging
 	void showFace(Meshy *mesh, std::vector<unsigned short> &face, bool world);
@@ -10,7 +10,9 @@ TouchMode::TouchMode()
 	_subModes.push_back("face");
 	
 	_face = MyNode::create("touchFace");
+	_face->setTag("helper");
 	_vertex = app->duplicateModelNode("sphere");
+	_vertex->setTag("helper");
 	_vertex->setScale(0.10f);
 	_vertex->getModel()->setMaterial("res/common/models.material#red");
 	_hullCheckbox = (CheckBox*) _controls->getControl("hulls");